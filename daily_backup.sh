@@ -9,13 +9,25 @@ BASE_FOLDER="$BACKUP_FOLDER/Base"
 TODAY=$(date +%F)   # YYYY-MM-DD format
 DAILY_FOLDER="$BACKUP_FOLDER/$TODAY"
 
+# file_tracker change lists (see file_tracker_lists.sh). Every daily folder is
+# a differential against Base, so the cursor is not advanced by the dailies:
+# it stays where the last full comparison left it, and each day copies every
+# change listed since then.
+SOURCE_DIR="$SOURCE"
+CURSOR_FILE="$BACKUP_FOLDER/.file_tracker_cursor"
+if ! . "$(dirname "$0")/file_tracker_lists.sh"; then
+    echo "file_tracker_lists.sh must be installed next to this script"
+    exit 1
+fi
+
 mkdir -p "$BACKUP_FOLDER"
 
 # === Initial full backup ===
 if [ ! -d "$BASE_FOLDER" ]; then
     echo "Performing initial full backup..."
     mkdir -p "$BASE_FOLDER"
-    rsync -a --delete "$SOURCE/" "$BASE_FOLDER/"
+    mark_full_sync
+    rsync -a --delete "${RSYNC_EXCLUDES[@]}" "$SOURCE/" "$BASE_FOLDER/" && finish_full_sync
     echo "Initial backup completed to $BASE_FOLDER"
     exit 0
 fi
@@ -29,7 +41,32 @@ fi
 echo "Performing incremental backup for $TODAY..."
 mkdir -p "$DAILY_FOLDER"
 
-# Copy only changed files since last backup
-rsync -a --update --delete --compare-dest="$BASE_FOLDER" "$SOURCE/" "$DAILY_FOLDER/"
+# Copy only files that differ from Base
+if read_cursor && { [ -z "$CURSOR_ANCHOR" ] || [ -d "$BACKUP_FOLDER/$CURSOR_ANCHOR" ]; }; then
+    # Only the paths file_tracker reported since the cursor, instead of
+    # rescanning the whole tree. If the cursor was set by a full comparison
+    # after Base, the daily folder it produced (the anchor) holds the earlier
+    # differences, so its files are copied again too. --compare-dest skips
+    # whatever matches Base. Deletions need no action in a fresh daily folder.
+    PENDING=$(mktemp)
+    list_slice "$CHANGES_LIST" "$CHANGES_FROM" "$CHANGES_TO" "$PENDING"
+    if [ -n "$CURSOR_ANCHOR" ]; then
+        (cd "$BACKUP_FOLDER/$CURSOR_ANCHOR" && find . -type f -print0) >> "$PENDING"
+    fi
+    if rsync -a --update --from0 --files-from="$PENDING" --ignore-missing-args \
+            --compare-dest="$BASE_FOLDER" "$SOURCE/" "$DAILY_FOLDER/"; then
+        rm -f "$PENDING"
+    else
+        rm -f "$PENDING"
+        echo "Incremental backup failed"
+        exit 1
+    fi
+else
+    # No list covers everything since Base: compare the whole tree, and anchor
+    # the cursor at today's folder so later days can go on from the lists
+    mark_full_sync
+    rsync -a --update --delete "${RSYNC_EXCLUDES[@]}" --compare-dest="$BASE_FOLDER" "$SOURCE/" "$DAILY_FOLDER/" &&
+        finish_full_sync "$TODAY"
+fi
 
 echo "Incremental backup completed to $DAILY_FOLDER"
@@ -5,20 +5,28 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <stdint.h>
 
 
 // To build: gcc -o file_locator file_locator.c -l sqlite3
 
 #define MAX_PATH 4096
+#define MAX_SHARDS 8
 
 int verbose = 0;
 int found_count = 0;
+const char *content_query = NULL;   // -q: full-text query over the keywords file_tracker -K stores
+const char *checksum_query = NULL;  // -c: exact checksum
+int skipped_count = 0;
 
 char Checksum[128];
 
 // Forward declarations
 void search_database(const char *dbname, const char *db_path, const char *filename, int partial);
 void list_databases_and_search(const char *dir_path, const char *filename, int partial);
+void search_shards(const char *dbname, const char *db_path, const char *filename, int partial);
 
 int main(int argc, char *argv[]) {
     char *filename = NULL;
@@ -33,19 +41,23 @@ int main(int argc, char *argv[]) {
             partial = 1;
         } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
             dbname = argv[++i];
+        } else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+            content_query = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            checksum_query = argv[++i];
 	} else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
             verbose = 1;
 	} else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
-            fprintf(stderr, "Usage: %s -v -f FileName [-p] [-d DbName]\n", argv[0]);
+            fprintf(stderr, "Usage: %s -v [-f FileName [-p]] [-q Query] [-c Checksum] [-d DbName]\n", argv[0]);
             return 1;
         } else {
-            fprintf(stderr, "Usage: %s -v -f FileName [-p] [-d DbName]\n", argv[0]);
+            fprintf(stderr, "Usage: %s -v [-f FileName [-p]] [-q Query] [-c Checksum] [-d DbName]\n", argv[0]);
             return 1;
         }
     }
 
-    if (!filename) {
-        fprintf(stderr, "Error: -f FileName is required\n");
+    if (!filename && !content_query && !checksum_query) {
+        fprintf(stderr, "Error: -f FileName, -q Query or -c Checksum is required\n");
         return 1;
     }
 
@@ -65,14 +77,97 @@ int main(int argc, char *argv[]) {
         char db_path[MAX_PATH];
         snprintf(db_path, sizeof(db_path), "%s/%s", db_dir, dbname);
         search_database(dbname, db_path, filename, partial);
+        search_shards(dbname, db_path, filename, partial);
     } else {
         // Search all databases in the directory
         list_databases_and_search(db_dir, filename, partial);
     }
 
+    if (verbose && skipped_count > 0) {
+        fprintf(stderr, "Skipped %d database(s) ruled out by their Bloom filters\n", skipped_count);
+    }
     return found_count;
 }
 
+// ==== Bloom Filters ====
+// file_tracker writes <name>.bloom next to each <name>.db after closing it:
+// a BloomHeader followed by the bit array, with keys "n:<file name>" and
+// "c:<checksum>". Must match bloom_hash() in file_tracker.c.
+typedef struct {
+    char magic[8];
+    uint32_t hashes;
+    uint32_t reserved;
+    uint64_t bits;
+    uint64_t keys;
+} BloomHeader;
+
+void bloom_hash(char type, const char *key, uint64_t *h1, uint64_t *h2) {
+    uint64_t h = 1469598103934665603ULL;
+    h = (h ^ (unsigned char)type) * 1099511628211ULL;
+    h = (h ^ ':') * 1099511628211ULL;
+    for (const char *p = key; *p; p++) h = (h ^ (unsigned char)*p) * 1099511628211ULL;
+    *h1 = h;
+    h += 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    *h2 = (h ^ (h >> 31)) | 1;
+}
+
+long long mtime_ns(const struct stat *st) {
+#ifdef __APPLE__
+    return st->st_mtimespec.tv_sec * 1000000000LL + st->st_mtimespec.tv_nsec;
+#else
+    return st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+#endif
+}
+
+int bloom_test(const unsigned char *bits_data, const BloomHeader *h, char type, const char *key) {
+    uint64_t h1, h2;
+    bloom_hash(type, key, &h1, &h2);
+    for (uint32_t i = 0; i < h->hashes; i++) {
+        uint64_t bit = (h1 + i * h2) % h->bits;
+        if (!(bits_data[bit / 8] & (1 << (bit % 8)))) return 0;
+    }
+    return 1;
+}
+
+// 0 only if the database's filter proves an exact name (-f without -p) or
+// checksum (-c) is absent. A missing, malformed or out-of-date filter (the
+// database or its WAL written since) means the database must be searched.
+int bloom_may_match(const char *db_path, const char *filename, int partial) {
+    int check_name = filename && !partial;
+    if (!check_name && !checksum_query) return 1;
+
+    char bloom_path[MAX_PATH], wal_path[MAX_PATH + 4];
+    size_t len = strlen(db_path);
+    if (len <= 3) return 1;
+    snprintf(bloom_path, sizeof(bloom_path), "%.*s.bloom", (int)(len - 3), db_path);
+    snprintf(wal_path, sizeof(wal_path), "%s-wal", db_path);
+
+    struct stat bloom_st, db_st, wal_st;
+    if (stat(bloom_path, &bloom_st) != 0 || stat(db_path, &db_st) != 0) return 1;
+    if (mtime_ns(&bloom_st) < mtime_ns(&db_st)) return 1;
+    if (stat(wal_path, &wal_st) == 0 && wal_st.st_size > 0 && mtime_ns(&bloom_st) < mtime_ns(&wal_st)) return 1;
+    if (bloom_st.st_size < (off_t)sizeof(BloomHeader)) return 1;
+
+    int fd = open(bloom_path, O_RDONLY);
+    if (fd < 0) return 1;
+    void *map = mmap(NULL, bloom_st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 1;
+
+    const BloomHeader *h = map;
+    int result = 1;
+    if (memcmp(h->magic, "FTBLOOM1", 8) == 0 && h->bits > 0 && h->hashes > 0 &&
+        (uint64_t)bloom_st.st_size == sizeof(BloomHeader) + h->bits / 8) {
+        const unsigned char *bits_data = (const unsigned char *)map + sizeof(BloomHeader);
+        if (check_name && !bloom_test(bits_data, h, 'n', filename)) result = 0;
+        if (checksum_query && !bloom_test(bits_data, h, 'c', checksum_query)) result = 0;
+    }
+    munmap(map, bloom_st.st_size);
+    return result;
+}
+
 void search_database(const char *dbname, const char *db_path, const char *filename, int partial) {
     sqlite3 *db;
     sqlite3_stmt *stmt;
@@ -83,6 +178,11 @@ void search_database(const char *dbname, const char *db_path, const char *filena
         return; // skip missing or inaccessible files
     }
 
+    if (!bloom_may_match(db_path, filename, partial)) {
+        skipped_count++;
+        return;
+    }
+
     rc = sqlite3_open(db_path, &db);
     if (rc) {
         fprintf(stderr, "Cannot open database %s: %s\n", db_path, sqlite3_errmsg(db));
@@ -90,15 +190,30 @@ void search_database(const char *dbname, const char *db_path, const char *filena
         return;
     }
 
+    // -q uses the files_fts index when file_tracker could build one,
+    // otherwise a substring match on keywords
     char sql[512];
-    if (partial) {
-        snprintf(sql, sizeof(sql),
-                 "SELECT id, file_name, full_path, size, created, last_modified, owner, checksum "
-                 "FROM files WHERE file_name LIKE ?;");
-    } else {
-        snprintf(sql, sizeof(sql),
-                 "SELECT id, file_name, full_path, size, created, last_modified, owner, checksum "
-                 "FROM files WHERE file_name = ?;");
+    int fts = 0;
+    int len = snprintf(sql, sizeof(sql),
+                       "SELECT f.id, f.file_name, f.full_path, f.size, f.created, f.last_modified, f.owner, f.checksum, f.keywords "
+                       "FROM files f");
+    if (content_query) {
+        sqlite3_stmt *probe;
+        if (sqlite3_prepare_v2(db, "SELECT 1 FROM files_fts LIMIT 0", -1, &probe, NULL) == SQLITE_OK) {
+            sqlite3_finalize(probe);
+            fts = 1;
+        }
+        len += snprintf(sql + len, sizeof(sql) - len, fts
+                        ? " JOIN files_fts ON files_fts.rowid = f.id WHERE files_fts MATCH ?"
+                        : " WHERE f.keywords LIKE ?");
+    }
+    if (filename) {
+        len += snprintf(sql + len, sizeof(sql) - len, "%s f.file_name %s ?",
+                        content_query ? " AND" : " WHERE", partial ? "LIKE" : "=");
+    }
+    if (checksum_query) {
+        snprintf(sql + len, sizeof(sql) - len, "%s f.checksum = ?",
+                 (content_query || filename) ? " AND" : " WHERE");
     }
 
     rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
@@ -108,12 +223,24 @@ void search_database(const char *dbname, const char *db_path, const char *filena
         return;
     }
 
-    char pattern[MAX_PATH];
-    if (partial) {
+    char pattern[MAX_PATH], query_pattern[MAX_PATH];
+    int param = 1;
+    if (content_query) {
+        if (fts) {
+            sqlite3_bind_text(stmt, param++, content_query, -1, SQLITE_STATIC);
+        } else {
+            snprintf(query_pattern, sizeof(query_pattern), "%%%s%%", content_query);
+            sqlite3_bind_text(stmt, param++, query_pattern, -1, SQLITE_STATIC);
+        }
+    }
+    if (filename && partial) {
         snprintf(pattern, sizeof(pattern), "%%%s%%", filename);
-        sqlite3_bind_text(stmt, 1, pattern, -1, SQLITE_STATIC);
-    } else {
-        sqlite3_bind_text(stmt, 1, filename, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, param++, pattern, -1, SQLITE_STATIC);
+    } else if (filename) {
+        sqlite3_bind_text(stmt, param++, filename, -1, SQLITE_STATIC);
+    }
+    if (checksum_query) {
+        sqlite3_bind_text(stmt, param, checksum_query, -1, SQLITE_STATIC);
     }
 
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
@@ -131,7 +258,15 @@ void search_database(const char *dbname, const char *db_path, const char *filena
             printf("    Created: %lld\n", sqlite3_column_int64(stmt, 4));
             printf("    Last Modified: %lld\n", sqlite3_column_int64(stmt, 5));
             printf("    Owner: %s\n", sqlite3_column_text(stmt, 6));
-            printf("    Checksum: %s\n\n", sqlite3_column_text(stmt, 7));
+            printf("    Checksum: %s\n", sqlite3_column_text(stmt, 7));
+            if (sqlite3_column_type(stmt, 8) != SQLITE_NULL) {
+                printf("    Keywords: %s\n", sqlite3_column_text(stmt, 8));
+            }
+            printf("\n");
+	}
+	else if (!filename) {
+            // Content matches are different files; a checksum comparison means nothing
+            printf("%24.24s, %s\n", dbname, sqlite3_column_text(stmt, 2));
 	}
 	else {
             if( strcmp( Checksum, (char *)sqlite3_column_text(stmt, 7) ) != 0 ) {
@@ -143,10 +278,66 @@ void search_database(const char *dbname, const char *db_path, const char *filena
         }
     }
 
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Query failed on %s: %s\n", db_path, sqlite3_errmsg(db));
+    }
+
     sqlite3_finalize(stmt);
     sqlite3_close(db);
 }
 
+// <name>.shard<k>.db, written by "file_tracker -S"
+int is_shard_file(const char *name) {
+    const char *p = strstr(name, ".shard");
+    if (!p) return 0;
+    p += strlen(".shard");
+    if (*p < '0' || *p > '9') return 0;
+    while (*p >= '0' && *p <= '9') p++;
+    return strcmp(p, ".db") == 0;
+}
+
+// The run_id file_tracker -S stamps on every shard, empty if there is none
+void read_run_id(const char *db_path, char *run_id, size_t size) {
+    sqlite3 *db;
+    sqlite3_stmt *stmt;
+    run_id[0] = '\0';
+    if (sqlite3_open_v2(db_path, &db, SQLITE_OPEN_READONLY, NULL) == SQLITE_OK &&
+        sqlite3_prepare_v2(db, "SELECT value FROM metadata WHERE key = 'run_id'", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0)) {
+            snprintf(run_id, size, "%s", (const char *)sqlite3_column_text(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(db);
+}
+
+// Databases written with "file_tracker -S" keep most rows in
+// <name>.shard<k>.db next to <name>.db. file_tracker commits shard 0 last,
+// so a shard whose run_id differs from shard 0's was left by a run that did
+// not finish, and is skipped.
+void search_shards(const char *dbname, const char *db_path, const char *filename, int partial) {
+    size_t len = strlen(db_path);
+    if (len <= 3 || strcmp(db_path + len - 3, ".db") != 0) return;
+
+    char main_run[64];
+    int checked = 0;
+    for (int k = 1; k < MAX_SHARDS; k++) {
+        char shard_path[MAX_PATH], shard_run[64];
+        snprintf(shard_path, sizeof(shard_path), "%.*s.shard%d.db", (int)(len - 3), db_path, k);
+        if (access(shard_path, F_OK) != 0) break;
+        if (!checked) {
+            read_run_id(db_path, main_run, sizeof(main_run));
+            checked = 1;
+        }
+        read_run_id(shard_path, shard_run, sizeof(shard_run));
+        if (main_run[0] && strcmp(main_run, shard_run) != 0) {
+            fprintf(stderr, "Warning: Skipping %s, left by an unfinished file_tracker run\n", shard_path);
+            continue;
+        }
+        search_database(dbname, shard_path, filename, partial);
+    }
+}
+
 void list_databases_and_search(const char *dir_path, const char *filename, int partial) {
     DIR *dir = opendir(dir_path);
     if (!dir) {
@@ -161,7 +352,10 @@ void list_databases_and_search(const char *dir_path, const char *filename, int p
             char db_path[MAX_PATH];
             snprintf(db_path, sizeof(db_path), "%s/%s", dir_path, entry->d_name);
 	    if( strcmp(entry->d_name + (strlen( entry->d_name ) - 3), ".db") == 0 ) {
+                // Shards are searched with the database they belong to
+                if (is_shard_file(entry->d_name)) continue;
                 search_database(entry->d_name, db_path, filename, partial);
+                search_shards(entry->d_name, db_path, filename, partial);
                 any_found = 1;
             }
         }
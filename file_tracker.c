@@ -4,6 +4,7 @@
 #include <pwd.h>
 #include <sqlite3.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,10 +14,25 @@
 #include <libgen.h>
 #include <locale.h>
 #include <errno.h>
-
-#define HASH_SIZE 65
+#include <fcntl.h>
+#include <sys/xattr.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#elif defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#define HASH_SIZE 80     // "m<chunk MiB>:" + 64 hex digits for tree hashes
 #define MAX_PATH 4096
 #define MAX_IGNORES 1024
+#define INODE_BUCKETS 4096
+#define MAX_SHARDS 8
+#define SHARD_QUEUE_SIZE 1024
+#define CHUNK_DIGEST_SIZE 32
+#define BLOOM_BITS_PER_KEY 10   // about 1% false positives with 7 hashes
+#define BLOOM_HASHES 7
+#define HASH_XATTR "user.file_tracker.hash"
+#define IOPS_BLOCK (128 * 1024)     // bytes --max-iops counts as one read
 
 // ==== Globals ====
 int verbose = 0;
@@ -24,10 +40,22 @@ int update = 0;
 int verifyChecksum = 0;
 int showProgress = 0;
 int showSummary = 0;
+int writeChangeLists = 0;
+int shardCount = 1;
+int chunkMiB = 0;
+int hashThreads = 4;
+// Background mode (--max-read-rate, --max-iops, --cpu-threads, --idle)
+double maxReadMB = 0;
+int maxIops = 0;
+int cpuThreads = 0;
+int idlePriority = 0;
+double psiLimit = 10.0;
+int contentIndex = 0;
+int hashCache = 0;
 
 // Aggregate counters (Protected by global_count_mutex)
 int total_unchanged = 0, total_changed = 0, total_new = 0, total_missing = 0,
-    total_ignored = 0, total_error = 0;
+    total_moved = 0, total_ignored = 0, total_error = 0;
 
 // Progress tracking (Protected by progress_mutex)
 int total_files = 0;
@@ -39,13 +67,94 @@ int ignore_count = 0;
 
 pthread_mutex_t global_count_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t progress_mutex = PTHREAD_MUTEX_INITIALIZER;
+// The inode cache is shared by the writer threads of a sharded root
+pthread_mutex_t inode_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Everything learned from reading a file's contents
+typedef struct {
+    char checksum[HASH_SIZE];
+    unsigned char *chunks;      // tree hash chunk digests, NULL for a plain SHA-256
+    int chunk_count;
+    char *keywords;             // -K content keywords, NULL if not extracted
+} FileDigest;
+
+// Digests already computed this run, keyed by (st_dev, st_ino), so every
+// hardlink to the same inode is only read once.
+typedef struct InodeEntry {
+    dev_t dev;
+    ino_t ino;
+    FileDigest digest;
+    struct InodeEntry *next;
+} InodeEntry;
+
+typedef struct PathEntry {
+    char *path;
+    struct PathEntry *next;
+} PathEntry;
+
+// A row whose path has disappeared, collected by find_missing
+typedef struct {
+    char *path, *checksum;
+    long long size;
+} MissingRow;
+
+// Bloom filter of every file name and checksum in one database file, written
+// next to it as <name>.bloom (see bloom_write) so file_locator can skip
+// databases that cannot contain what it is looking for
+typedef struct {
+    char magic[8];              // "FTBLOOM1"
+    uint32_t hashes;
+    uint32_t reserved;
+    uint64_t bits;
+    uint64_t keys;
+} BloomHeader;
 
 typedef struct {
+    BloomHeader header;
+    unsigned char *data;
+} Bloom;
+
+// Files handed from a root's traversal to one shard's writer thread
+typedef struct {
+    char *paths[SHARD_QUEUE_SIZE];
+    int head, count, closed;
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty, not_full;
+} ShardQueue;
+
+typedef struct ThreadContext {
     char source_path[MAX_PATH];
     char db_path[MAX_PATH];
     char log_path[MAX_PATH];
     FILE *log_fp;
-    int unchanged, changed, new, missing, ignored, error;
+    // NUL-separated rsync --files-from lists, relative to source_path
+    char changes_path[MAX_PATH];
+    char deletes_path[MAX_PATH];
+    FILE *changes_fp, *deletes_fp;
+    int unchanged, changed, new, missing, moved, ignored, error;
+    InodeEntry **inode_buckets;
+    // Old paths of rows matched as MOVED, skipped by the missing-file pass
+    PathEntry **moved_buckets;
+    // Rows with this id or higher were inserted as NEW during this run
+    sqlite3_int64 first_new_id;
+    // Rows and bytes left in the files table once this run commits
+    long long file_count, total_bytes;
+    // Bytes read to compute checksums this run
+    long long bytes_hashed;
+    // Sharded roots: the root's traversal feeds shard_count writer contexts
+    struct ThreadContext *shards;
+    int shard_count;
+    ShardQueue *queue;
+    sqlite3 *db;
+    // Shards: the root they belong to, and the disappeared rows find_missing
+    // could not pair within the shard, left for pair_across_shards
+    struct ThreadContext *root;
+    MissingRow *unpaired;
+    int unpaired_count;
+    // Sharded roots: stamped on every shard, shard 0 last (see run_sharded)
+    char run_id[64];
+    // Filled by find_missing, written once the database is closed
+    Bloom *bloom;
 } ThreadContext;
 
 // ==== Ignore List Helpers ====
@@ -132,8 +241,406 @@ void log_message(ThreadContext *ctx, const char *status, const char *path) {
     }
 }
 
+// ==== Change Lists ====
+// Append a path, relative to the root being scanned, to an rsync
+// --from0 --files-from list.
+void list_change(ThreadContext *ctx, FILE *fp, const char *path) {
+    if (!fp) return;
+    size_t root_len = strlen(ctx->source_path);
+    const char *rel = path;
+    if (strncmp(path, ctx->source_path, root_len) == 0) rel = path + root_len;
+    while (*rel == '/') rel++;
+    // Shard writers share the root's lists; keep each entry contiguous
+    flockfile(fp);
+    fputs(rel, fp);
+    fputc('\0', fp);
+    funlockfile(fp);
+}
+
+// The lists are append-only and shared by every backup destination, each of
+// which keeps its own offset into them. <name>.listid names the current pair:
+// it is renewed whenever the lists are started afresh, and a -u run without -L
+// removes all three, so a destination holding an offset for another id knows
+// it may have missed changes and falls back to a full sync.
+void open_change_lists(ThreadContext *ctx) {
+    char id_path[MAX_PATH];
+    snprintf(id_path, sizeof(id_path), "%.*s.listid",
+             (int)(strlen(ctx->changes_path) - strlen(".changes")), ctx->changes_path);
+    if (!writeChangeLists) {
+        if (update) {
+            unlink(id_path);
+            unlink(ctx->changes_path);
+            unlink(ctx->deletes_path);
+        }
+        return;
+    }
+
+    int fresh = access(id_path, F_OK) != 0 || access(ctx->changes_path, F_OK) != 0 ||
+                access(ctx->deletes_path, F_OK) != 0;
+    if (fresh) unlink(id_path);
+    ctx->changes_fp = fopen(ctx->changes_path, fresh ? "w" : "a");
+    ctx->deletes_fp = fopen(ctx->deletes_path, fresh ? "w" : "a");
+    if (!ctx->changes_fp || !ctx->deletes_fp) {
+        fprintf(stderr, "Warning: Could not open change lists for %s: %s\n", ctx->source_path, strerror(errno));
+        // This run's changes go unlisted, so the lists no longer cover them
+        unlink(id_path);
+        return;
+    }
+    if (fresh) {
+        FILE *f = fopen(id_path, "w");
+        if (f) {
+            fprintf(f, "%lld-%d\n", (long long)time(NULL), (int)getpid());
+            fclose(f);
+        }
+    }
+}
+
+// ==== Throttling ====
+// Every read made while hashing draws from one token bucket shared by all
+// threads. While /proc/pressure/io shows foreground tasks stalling on I/O
+// the rates and the --cpu-threads slots are halved, down to 1/16 (at least
+// one slot), and recover gradually once it eases.
+typedef struct {
+    double byte_rate, op_rate;      // configured limits, 0 = unlimited
+    double scale;
+    double byte_tokens, op_tokens;
+    struct timespec last_refill, last_psi;
+    pthread_mutex_t mutex;
+} Throttle;
+
+Throttle throttle = { .scale = 1.0, .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+// --cpu-threads: hashes (whole files or chunks) running at once
+int hash_slots_used = 0;
+pthread_mutex_t hash_slot_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t hash_slot_free = PTHREAD_COND_INITIALIZER;
+
+double seconds_between(const struct timespec *a, const struct timespec *b) {
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+// "some avg10" of /proc/pressure/io: the share of the last 10 s in which a
+// task waited on I/O. -1 where PSI is unavailable (macOS, older kernels).
+double io_pressure() {
+    FILE *f = fopen("/proc/pressure/io", "r");
+    if (!f) return -1;
+    double avg10;
+    if (fscanf(f, "some avg10=%lf", &avg10) != 1) avg10 = -1;
+    fclose(f);
+    return avg10;
+}
+
+// Re-read PSI at most once a second. Call with throttle.mutex held.
+void update_pressure_scale(const struct timespec *now) {
+    if (seconds_between(&throttle.last_psi, now) < 1.0) return;
+    double pressure = io_pressure();
+    if (pressure > psiLimit) {
+        throttle.scale = throttle.scale / 2 < 1.0 / 16 ? 1.0 / 16 : throttle.scale / 2;
+    } else if (pressure >= 0) {
+        throttle.scale = throttle.scale + 0.1 > 1.0 ? 1.0 : throttle.scale + 0.1;
+    }
+    throttle.last_psi = *now;
+}
+
+// Charge a read of bytes, already made, to the bucket and sleep off any
+// deficit. Tokens go negative so concurrent readers queue behind each
+// other's debt. --max-iops counts reads in IOPS_BLOCK units, about what
+// readahead asks of the device for a sequential read, rather than per call,
+// so the limit does not depend on the callers' buffer sizes. The first read
+// of a file or chunk (first != 0) counts as at least one, as it needs a seek.
+void throttle_read(size_t bytes, int first) {
+    if (throttle.byte_rate <= 0 && throttle.op_rate <= 0) return;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    pthread_mutex_lock(&throttle.mutex);
+    update_pressure_scale(&now);
+    double elapsed = seconds_between(&throttle.last_refill, &now);
+    throttle.last_refill = now;
+
+    // Up to one second's worth may be spent as a burst
+    double wait = 0;
+    if (throttle.byte_rate > 0) {
+        double rate = throttle.byte_rate * throttle.scale;
+        throttle.byte_tokens += elapsed * rate;
+        if (throttle.byte_tokens > rate) throttle.byte_tokens = rate;
+        throttle.byte_tokens -= bytes;
+        if (throttle.byte_tokens < 0) wait = -throttle.byte_tokens / rate;
+    }
+    if (throttle.op_rate > 0) {
+        double rate = throttle.op_rate * throttle.scale;
+        throttle.op_tokens += elapsed * rate;
+        if (throttle.op_tokens > rate) throttle.op_tokens = rate;
+        double ops = (double)bytes / IOPS_BLOCK;
+        throttle.op_tokens -= (first && ops < 1) ? 1 : ops;
+        if (throttle.op_tokens < 0 && -throttle.op_tokens / rate > wait) wait = -throttle.op_tokens / rate;
+    }
+    pthread_mutex_unlock(&throttle.mutex);
+
+    if (wait > 0) {
+        struct timespec ts = { (time_t)wait, (long)((wait - (time_t)wait) * 1e9) };
+        nanosleep(&ts, NULL);
+    }
+}
+
+void hash_slot_acquire() {
+    if (cpuThreads <= 0) return;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    pthread_mutex_lock(&throttle.mutex);
+    update_pressure_scale(&now);
+    int slots = (int)(cpuThreads * throttle.scale);
+    pthread_mutex_unlock(&throttle.mutex);
+    if (slots < 1) slots = 1;
+
+    pthread_mutex_lock(&hash_slot_mutex);
+    while (hash_slots_used >= slots) pthread_cond_wait(&hash_slot_free, &hash_slot_mutex);
+    hash_slots_used++;
+    pthread_mutex_unlock(&hash_slot_mutex);
+}
+
+void hash_slot_release() {
+    if (cpuThreads <= 0) return;
+    pthread_mutex_lock(&hash_slot_mutex);
+    hash_slots_used--;
+    pthread_cond_signal(&hash_slot_free);
+    pthread_mutex_unlock(&hash_slot_mutex);
+}
+
+// --idle: idle I/O class and lowest CPU priority. Set before any thread is
+// created so every thread inherits them.
+void enter_idle_priority() {
+#ifdef __linux__
+    // IOPRIO_WHO_PROCESS, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT
+    if (syscall(SYS_ioprio_set, 1, 0, 3 << 13) != 0) {
+        fprintf(stderr, "Warning: Could not set idle I/O priority: %s\n", strerror(errno));
+    }
+#elif defined(__APPLE__)
+    setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_PROCESS, IOPOL_THROTTLE);
+#endif
+    errno = 0;
+    if (nice(19) == -1 && errno != 0) {
+        fprintf(stderr, "Warning: Could not lower CPU priority: %s\n", strerror(errno));
+    }
+}
+
+// ==== Content Extraction ====
+// With -K the bytes read for hashing are also fed through a chain of
+// extractors, so keywords cost no extra reads. Only the first
+// CONTENT_SCAN_BYTES of a file are examined. keywords holds the sniffed MIME
+// type followed, for text, by the most frequent terms.
+#define CONTENT_SCAN_BYTES (4 << 20)
+#define TERM_BUCKETS 4096
+#define MAX_TERMS 20000
+#define TOP_TERMS 16
+#define MIN_TERM 3
+#define MAX_TERM 24
+
+typedef struct TermEntry {
+    char term[MAX_TERM + 1];
+    int count;
+    struct TermEntry *next;
+} TermEntry;
+
+typedef struct {
+    size_t seen;
+    const char *mime;
+    int is_text;
+    char token[MAX_TERM + 1];
+    int token_len, token_alpha, token_overflow;
+    TermEntry **terms;
+    int term_count;
+    char keywords[512];
+} ContentState;
+
+typedef struct {
+    const char *name;
+    void (*feed)(ContentState *cs, const unsigned char *buf, size_t len);
+    void (*finish)(ContentState *cs);
+} Extractor;
+
+typedef struct {
+    size_t offset, len;
+    const char *magic;
+    const char *mime;
+} MimeMagic;
+
+static const MimeMagic mime_magic[] = {
+    { 0, 5, "%PDF-", "application/pdf" },
+    { 0, 8, "\x89PNG\r\n\x1a\n", "image/png" },
+    { 0, 3, "\xff\xd8\xff", "image/jpeg" },
+    { 0, 4, "GIF8", "image/gif" },
+    { 4, 4, "ftyp", "video/mp4" },
+    { 0, 3, "ID3", "audio/mpeg" },
+    { 0, 4, "OggS", "audio/ogg" },
+    { 0, 4, "PK\x03\x04", "application/zip" },
+    { 0, 2, "\x1f\x8b", "application/gzip" },
+    { 0, 3, "BZh", "application/x-bzip2" },
+    { 0, 6, "\xfd" "7zXZ\0", "application/x-xz" },
+    { 0, 6, "7z\xbc\xaf\x27\x1c", "application/x-7z-compressed" },
+    { 0, 4, "\xd0\xcf\x11\xe0", "application/x-ole-storage" },
+    { 0, 16, "SQLite format 3", "application/vnd.sqlite3" },
+    { 0, 4, "\x7f" "ELF", "application/x-elf" },
+    { 0, 4, "\xcf\xfa\xed\xfe", "application/x-mach-binary" },
+    { 0, 5, "{\\rtf", "text/rtf" },
+    { 0, 5, "<?xml", "text/xml" },
+};
+
+static const char *stop_words[] = {
+    "the", "and", "for", "are", "but", "not", "you", "all", "any", "can", "had", "her", "was", "one",
+    "our", "out", "has", "his", "how", "its", "may", "who", "did", "get", "this", "that", "with",
+    "from", "have", "they", "will", "your", "been", "were", "which", "their", "there", "what",
+    "when", "than", "then", "them", "into", "also", "more", "some", "such", "only", "other",
+};
+
+// MIME type from magic numbers in the first block; otherwise text/plain if
+// it has no NULs and is mostly printable
+void mime_feed(ContentState *cs, const unsigned char *buf, size_t len) {
+    if (cs->seen > 0 || len == 0) return;
+    for (size_t i = 0; i < sizeof(mime_magic) / sizeof(mime_magic[0]); i++) {
+        const MimeMagic *m = &mime_magic[i];
+        if (len >= m->offset + m->len && memcmp(buf + m->offset, m->magic, m->len) == 0) {
+            cs->mime = m->mime;
+            cs->is_text = strncmp(m->mime, "text/", 5) == 0;
+            return;
+        }
+    }
+    size_t sample = len < 8192 ? len : 8192, printable = 0;
+    for (size_t i = 0; i < sample; i++) {
+        unsigned char c = buf[i];
+        if (c == 0) {
+            cs->mime = "application/octet-stream";
+            return;
+        }
+        if (c >= 0x20 || c == '\n' || c == '\r' || c == '\t' || c == '\f') printable++;
+    }
+    cs->is_text = printable * 10 >= sample * 9;
+    cs->mime = cs->is_text ? "text/plain" : "application/octet-stream";
+}
+
+void mime_finish(ContentState *cs) {
+    snprintf(cs->keywords, sizeof(cs->keywords), "%s", cs->mime ? cs->mime : "application/x-empty");
+}
+
+void add_term(ContentState *cs, const char *term) {
+    for (size_t i = 0; i < sizeof(stop_words) / sizeof(stop_words[0]); i++) {
+        if (strcmp(term, stop_words[i]) == 0) return;
+    }
+    unsigned int b = 5381;
+    for (const char *p = term; *p; p++) b = b * 33 + (unsigned char)*p;
+    b %= TERM_BUCKETS;
+    for (TermEntry *e = cs->terms[b]; e; e = e->next) {
+        if (strcmp(e->term, term) == 0) {
+            e->count++;
+            return;
+        }
+    }
+    if (cs->term_count >= MAX_TERMS) return;
+    TermEntry *e = malloc(sizeof(TermEntry));
+    if (!e) return;
+    snprintf(e->term, sizeof(e->term), "%s", term);
+    e->count = 1;
+    e->next = cs->terms[b];
+    cs->terms[b] = e;
+    cs->term_count++;
+}
+
+// Terms of 3-24 letters, digits or UTF-8 bytes containing at least one
+// letter, ASCII folded to lower case. Longer runs (hashes, base64) are dropped.
+void end_token(ContentState *cs) {
+    if (cs->token_len >= MIN_TERM && !cs->token_overflow && cs->token_alpha) {
+        cs->token[cs->token_len] = '\0';
+        add_term(cs, cs->token);
+    }
+    cs->token_len = cs->token_alpha = cs->token_overflow = 0;
+}
+
+void text_feed(ContentState *cs, const unsigned char *buf, size_t len) {
+    if (!cs->is_text) return;
+    if (!cs->terms && !(cs->terms = calloc(TERM_BUCKETS, sizeof(TermEntry *)))) {
+        cs->is_text = 0;
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = buf[i];
+        int letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+        if (!letter && !(c >= '0' && c <= '9')) {
+            end_token(cs);
+            continue;
+        }
+        if (cs->token_len == MAX_TERM) {
+            cs->token_overflow = 1;
+            continue;
+        }
+        cs->token[cs->token_len++] = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+        cs->token_alpha |= letter;
+    }
+}
+
+void text_finish(ContentState *cs) {
+    if (cs->is_text) end_token(cs);
+}
+
+void top_terms_finish(ContentState *cs) {
+    if (!cs->terms) return;
+    TermEntry *top[TOP_TERMS];
+    int top_count = 0;
+    for (int b = 0; b < TERM_BUCKETS; b++) {
+        for (TermEntry *e = cs->terms[b]; e; e = e->next) {
+            if (top_count == TOP_TERMS && e->count <= top[top_count - 1]->count) continue;
+            int i = top_count < TOP_TERMS ? top_count++ : TOP_TERMS - 1;
+            while (i > 0 && top[i - 1]->count < e->count) {
+                top[i] = top[i - 1];
+                i--;
+            }
+            top[i] = e;
+        }
+    }
+    size_t len = strlen(cs->keywords);
+    for (int i = 0; i < top_count && len < sizeof(cs->keywords); i++) {
+        len += snprintf(cs->keywords + len, sizeof(cs->keywords) - len, " %s", top[i]->term);
+    }
+}
+
+// Run in order for every block; finish() runs in order once at the end
+static const Extractor extractors[] = {
+    { "mime", mime_feed, mime_finish },
+    { "text", text_feed, text_finish },
+    { "top_terms", NULL, top_terms_finish },
+};
+
+void content_feed(ContentState *cs, const unsigned char *buf, size_t len) {
+    if (!cs || cs->seen >= CONTENT_SCAN_BYTES) return;
+    if (len > CONTENT_SCAN_BYTES - cs->seen) len = CONTENT_SCAN_BYTES - cs->seen;
+    for (size_t i = 0; i < sizeof(extractors) / sizeof(extractors[0]); i++) {
+        if (extractors[i].feed) extractors[i].feed(cs, buf, len);
+    }
+    cs->seen += len;
+}
+
+// Returns the keywords (caller frees)
+char *content_finish(ContentState *cs) {
+    for (size_t i = 0; i < sizeof(extractors) / sizeof(extractors[0]); i++) {
+        if (extractors[i].finish) extractors[i].finish(cs);
+    }
+    if (cs->terms) {
+        for (int b = 0; b < TERM_BUCKETS; b++) {
+            TermEntry *e = cs->terms[b];
+            while (e) {
+                TermEntry *next = e->next;
+                free(e);
+                e = next;
+            }
+        }
+        free(cs->terms);
+        cs->terms = NULL;
+    }
+    return strdup(cs->keywords);
+}
+
 // ==== Utility Functions ====
-void compute_sha256(const char *path, char *outputBuffer) {
+// cs, if set, is also fed every block read
+void compute_sha256(const char *path, char *outputBuffer, ContentState *cs) {
     FILE *file = fopen(path, "rb");
     if (!file) {
         strcpy(outputBuffer, "");
@@ -145,9 +652,12 @@ void compute_sha256(const char *path, char *outputBuffer) {
     EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL);
     const int bufSize = 32768;
     unsigned char *buffer = malloc(bufSize);
-    int bytesRead;
+    int bytesRead, first = 1;
     while ((bytesRead = fread(buffer, 1, bufSize, file))) {
+        throttle_read(bytesRead, first);
+        first = 0;
         EVP_DigestUpdate(mdctx, buffer, bytesRead);
+        content_feed(cs, buffer, bytesRead);
     }
     EVP_DigestFinal_ex(mdctx, hash, &hash_len);
     for (unsigned int i = 0; i < hash_len; i++) {
@@ -159,12 +669,181 @@ void compute_sha256(const char *path, char *outputBuffer) {
     free(buffer);
 }
 
+// ==== Tree Hashing ====
+// With -M, files larger than one chunk are hashed as a tree: every chunk is
+// hashed on its own by a pool of threads and the checksum is the SHA-256 of
+// the concatenated chunk digests, stored as "m<chunk MiB>:<hex>". The chunk
+// digests are kept in files.chunk_hashes so ft_verify can name bad chunks.
+typedef struct {
+    int fd;
+    long long size, chunk_bytes;
+    int chunk_count, next_chunk, failed;
+    unsigned char *digests;
+    ContentState *content;      // fed by whichever thread hashes chunk 0
+    pthread_mutex_t mutex;
+} TreeHash;
+
+// Chunk size of a tree hash checksum, 0 for a plain SHA-256
+int checksum_chunk_mib(const char *checksum) {
+    if (!checksum || checksum[0] != 'm') return 0;
+    char *end;
+    long mib = strtol(checksum + 1, &end, 10);
+    return (*end == ':' && mib > 0) ? (int)mib : 0;
+}
+
+void *tree_hash_worker(void *arg) {
+    TreeHash *th = (TreeHash *)arg;
+    const size_t bufSize = 1 << 20;
+    unsigned char *buffer = malloc(bufSize);
+    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
+    if (!buffer || !mdctx) {
+        pthread_mutex_lock(&th->mutex);
+        th->failed = 1;
+        pthread_mutex_unlock(&th->mutex);
+    }
+
+    while (buffer && mdctx) {
+        pthread_mutex_lock(&th->mutex);
+        int chunk = th->failed ? th->chunk_count : th->next_chunk++;
+        pthread_mutex_unlock(&th->mutex);
+        if (chunk >= th->chunk_count) break;
+
+        long long offset = (long long)chunk * th->chunk_bytes;
+        long long remaining = th->size - offset < th->chunk_bytes ? th->size - offset : th->chunk_bytes;
+        ssize_t n = 0;
+        int first = 1;
+        hash_slot_acquire();
+        EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL);
+        while (remaining > 0) {
+            n = pread(th->fd, buffer, remaining < (long long)bufSize ? (size_t)remaining : bufSize, offset);
+            if (n <= 0) break;  // a file truncated mid-run hashes what was read
+            throttle_read(n, first);
+            first = 0;
+            EVP_DigestUpdate(mdctx, buffer, n);
+            if (chunk == 0) content_feed(th->content, buffer, n);
+            offset += n;
+            remaining -= n;
+        }
+        EVP_DigestFinal_ex(mdctx, th->digests + (size_t)chunk * CHUNK_DIGEST_SIZE, NULL);
+        hash_slot_release();
+        if (n < 0) {
+            pthread_mutex_lock(&th->mutex);
+            th->failed = 1;
+            pthread_mutex_unlock(&th->mutex);
+        }
+    }
+    EVP_MD_CTX_free(mdctx);
+    free(buffer);
+    return NULL;
+}
+
+// Tree hash of the first size bytes of path into d's checksum and chunks;
+// on failure the checksum is ""
+void compute_tree_hash(const char *path, long long size, int chunk_mib, FileDigest *d, ContentState *cs) {
+    TreeHash th;
+    memset(&th, 0, sizeof(th));
+    char *checksum = d->checksum;
+    checksum[0] = '\0';
+    th.content = cs;
+
+    th.fd = open(path, O_RDONLY);
+    if (th.fd < 0) return;
+    th.size = size;
+    th.chunk_bytes = (long long)chunk_mib << 20;
+    th.chunk_count = (int)((size + th.chunk_bytes - 1) / th.chunk_bytes);
+    th.digests = malloc((size_t)th.chunk_count * CHUNK_DIGEST_SIZE);
+    if (!th.digests) {
+        close(th.fd);
+        return;
+    }
+    pthread_mutex_init(&th.mutex, NULL);
+
+    int thread_count = hashThreads < th.chunk_count ? hashThreads : th.chunk_count;
+    if (cpuThreads > 0 && cpuThreads < thread_count) thread_count = cpuThreads;
+    pthread_t threads[thread_count];
+    int started = 0;
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&threads[started], NULL, tree_hash_worker, &th) == 0) started++;
+    }
+    if (started == 0) tree_hash_worker(&th);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&th.mutex);
+    close(th.fd);
+
+    if (th.failed) {
+        free(th.digests);
+        return;
+    }
+
+    unsigned char root[EVP_MAX_MD_SIZE];
+    unsigned int root_len;
+    EVP_Digest(th.digests, (size_t)th.chunk_count * CHUNK_DIGEST_SIZE, root, &root_len, EVP_sha256(), NULL);
+    int len = snprintf(checksum, HASH_SIZE, "m%d:", chunk_mib);
+    for (unsigned int i = 0; i < root_len; i++) {
+        sprintf(checksum + len + (i * 2), "%02x", root[i]);
+    }
+    d->chunks = th.digests;
+    d->chunk_count = th.chunk_count;
+}
+
 void get_owner(uid_t uid, char *owner, size_t size) {
-    struct passwd *pw = getpwuid(uid);
+    struct passwd pwd, *pw = NULL;
+    char buf[1024];
+    getpwuid_r(uid, &pwd, buf, sizeof(buf), &pw);
     if (pw) snprintf(owner, size, "%s", pw->pw_name);
     else snprintf(owner, size, "%d", uid);
 }
 
+// ==== Hash Cache (xattr) ====
+// With -x a file's checksum is kept in the HASH_XATTR extended attribute as
+// "sha256 <checksum> <size> <mtime_ns>". Any database over the same file,
+// or over a copy made with xattrs preserved, can reuse it while the size
+// and mtime still match instead of reading the file again.
+long long mtime_ns(const struct stat *st) {
+#ifdef __APPLE__
+    return st->st_mtimespec.tv_sec * 1000000000LL + st->st_mtimespec.tv_nsec;
+#else
+    return st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+#endif
+}
+
+// Returns 1 and fills checksum when the cached hash is current and in the
+// format (plain or tree hash with chunk_mib) this run would compute
+int hash_cache_get(const char *path, const struct stat *st, int chunk_mib, char *checksum) {
+    char value[256], algorithm[16], hash[HASH_SIZE];
+    long long size, mtime;
+#ifdef __APPLE__
+    ssize_t n = getxattr(path, HASH_XATTR, value, sizeof(value) - 1, 0, 0);
+#else
+    ssize_t n = getxattr(path, HASH_XATTR, value, sizeof(value) - 1);
+#endif
+    if (n <= 0) return 0;
+    value[n] = '\0';
+    if (sscanf(value, "%15s %79s %lld %lld", algorithm, hash, &size, &mtime) != 4) return 0;
+    if (strcmp(algorithm, "sha256") != 0 || strlen(hash) < 64) return 0;
+    if (size != (long long)st->st_size || mtime != mtime_ns(st)) return 0;
+    if (checksum_chunk_mib(hash) != chunk_mib) return 0;
+    snprintf(checksum, HASH_SIZE, "%s", hash);
+    return 1;
+}
+
+// Record a checksum computed from st's version of the file. Skipped if the
+// file changed while it was read; filesystems without user xattrs and files
+// we may not write are silently left uncached.
+void hash_cache_put(const char *path, const struct stat *st, const char *checksum) {
+    struct stat now;
+    if (stat(path, &now) != 0 || now.st_size != st->st_size || mtime_ns(&now) != mtime_ns(st)) return;
+    char value[256];
+    int len = snprintf(value, sizeof(value), "sha256 %s %lld %lld", checksum, (long long)st->st_size, mtime_ns(st));
+#ifdef __APPLE__
+    setxattr(path, HASH_XATTR, value, len, 0, 0);
+#else
+    setxattr(path, HASH_XATTR, value, len, 0);
+#endif
+}
+
 // ==== Utility: Create directory with parents ====
 int mkdir_p(const char *path) {
     char tmp[MAX_PATH];
@@ -190,13 +869,283 @@ int mkdir_p(const char *path) {
     return 0;
 }
 
+// ==== Run Metadata ====
+// Small key/value table rewritten inside each run's transaction so status
+// tools (file_tracker_lastrun) can answer without scanning meta or files.
+void set_metadata(sqlite3 *db, const char *key, const char *value) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO metadata (key, value) VALUES (?, ?)", -1, &stmt, NULL) != SQLITE_OK) return;
+    sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, value, -1, SQLITE_STATIC);
+    sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+}
+
+void set_metadata_int(sqlite3 *db, const char *key, long long value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lld", value);
+    set_metadata(db, key, buf);
+}
+
+void set_metadata_now(sqlite3 *db, const char *key) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO metadata (key, value) VALUES (?, datetime('now','localtime'))", -1, &stmt, NULL) != SQLITE_OK) return;
+    sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+    sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+}
+
+// ==== Inode Tracking ====
+unsigned int inode_bucket(dev_t dev, ino_t ino) {
+    unsigned long long h = (unsigned long long)ino * 0x9E3779B97F4A7C15ULL ^ (unsigned long long)dev;
+    return (unsigned int)(h >> 32) % INODE_BUCKETS;
+}
+
+void digest_free(FileDigest *d) {
+    free(d->chunks);
+    free(d->keywords);
+    d->chunks = NULL;
+    d->keywords = NULL;
+    d->chunk_count = 0;
+}
+
+void digest_copy(FileDigest *dst, const FileDigest *src) {
+    memcpy(dst->checksum, src->checksum, sizeof(dst->checksum));
+    dst->chunks = NULL;
+    dst->chunk_count = 0;
+    if (src->chunks && (dst->chunks = malloc((size_t)src->chunk_count * CHUNK_DIGEST_SIZE))) {
+        memcpy(dst->chunks, src->chunks, (size_t)src->chunk_count * CHUNK_DIGEST_SIZE);
+        dst->chunk_count = src->chunk_count;
+    }
+    dst->keywords = src->keywords ? strdup(src->keywords) : NULL;
+}
+
+// Copy the cached digest of an inode into d if it is in the format wanted
+// (chunk_mib for a tree hash, 0 for a plain SHA-256). Returns 1 on a hit.
+int inode_cache_get(ThreadContext *ctx, dev_t dev, ino_t ino, int chunk_mib, FileDigest *d) {
+    int hit = 0;
+    pthread_mutex_lock(&inode_cache_mutex);
+    for (InodeEntry *e = ctx->inode_buckets[inode_bucket(dev, ino)]; e; e = e->next) {
+        if (e->dev == dev && e->ino == ino && checksum_chunk_mib(e->digest.checksum) == chunk_mib) {
+            digest_copy(d, &e->digest);
+            hit = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&inode_cache_mutex);
+    return hit;
+}
+
+void inode_cache_store(ThreadContext *ctx, dev_t dev, ino_t ino, const FileDigest *d) {
+    unsigned int b = inode_bucket(dev, ino);
+    InodeEntry *e = malloc(sizeof(InodeEntry));
+    if (!e) return;
+    e->dev = dev;
+    e->ino = ino;
+    digest_copy(&e->digest, d);
+    pthread_mutex_lock(&inode_cache_mutex);
+    e->next = ctx->inode_buckets[b];
+    ctx->inode_buckets[b] = e;
+    pthread_mutex_unlock(&inode_cache_mutex);
+}
+
+void inode_cache_free(ThreadContext *ctx) {
+    if (!ctx->inode_buckets) return;
+    for (int i = 0; i < INODE_BUCKETS; i++) {
+        InodeEntry *e = ctx->inode_buckets[i];
+        while (e) {
+            InodeEntry *next = e->next;
+            digest_free(&e->digest);
+            free(e);
+            e = next;
+        }
+    }
+    free(ctx->inode_buckets);
+    ctx->inode_buckets = NULL;
+}
+
+// Hash a file into d (caller frees with digest_free), reusing the digest of
+// a hardlink already hashed this run. chunk_mib > 0 tree-hashes files
+// larger than one chunk. With -K the same reads also produce the keywords.
+// With -x a current xattr hash is used instead of reading, except under -c
+// (which must read) and -K (which needs the contents); a hash reused this
+// way has no chunk digests.
+void hash_file(ThreadContext *ctx, const char *path, const struct stat *st, int chunk_mib, FileDigest *d) {
+    int tree = chunk_mib > 0 && st->st_size > ((long long)chunk_mib << 20);
+    memset(d, 0, sizeof(*d));
+    if (st->st_nlink > 1 && inode_cache_get(ctx, st->st_dev, st->st_ino, tree ? chunk_mib : 0, d)) return;
+    if (hashCache && !verifyChecksum && !contentIndex &&
+        hash_cache_get(path, st, tree ? chunk_mib : 0, d->checksum)) {
+        if (st->st_nlink > 1) inode_cache_store(ctx, st->st_dev, st->st_ino, d);
+        return;
+    }
+
+    ContentState content, *cs = NULL;
+    if (contentIndex) {
+        memset(&content, 0, sizeof(content));
+        cs = &content;
+    }
+    if (tree) compute_tree_hash(path, st->st_size, chunk_mib, d, cs);
+    else {
+        hash_slot_acquire();
+        compute_sha256(path, d->checksum, cs);
+        hash_slot_release();
+    }
+    if (cs) {
+        char *keywords = content_finish(cs);
+        if (d->checksum[0]) d->keywords = keywords;
+        else free(keywords);
+    }
+    if (d->checksum[0]) {
+        ctx->bytes_hashed += st->st_size;
+        if (hashCache && update) hash_cache_put(path, st, d->checksum);
+    }
+    if (st->st_nlink > 1 && d->checksum[0]) inode_cache_store(ctx, st->st_dev, st->st_ino, d);
+}
+
+void bind_chunks(sqlite3_stmt *stmt, int idx, const FileDigest *d) {
+    if (d->chunks) sqlite3_bind_blob(stmt, idx, d->chunks, d->chunk_count * CHUNK_DIGEST_SIZE, SQLITE_STATIC);
+    else sqlite3_bind_null(stmt, idx);
+}
+
+unsigned int string_hash(const char *str) {
+    unsigned int h = 5381;
+    while (*str) h = h * 33 + (unsigned char)*str++;
+    return h;
+}
+
+unsigned int path_bucket(const char *path) {
+    return string_hash(path) % INODE_BUCKETS;
+}
+
+int was_moved_from(ThreadContext *ctx, const char *path) {
+    for (PathEntry *e = ctx->moved_buckets[path_bucket(path)]; e; e = e->next) {
+        if (strcmp(e->path, path) == 0) return 1;
+    }
+    return 0;
+}
+
+void add_moved_from(ThreadContext *ctx, const char *path) {
+    unsigned int b = path_bucket(path);
+    PathEntry *e = malloc(sizeof(PathEntry));
+    if (!e) return;
+    e->path = strdup(path);
+    e->next = ctx->moved_buckets[b];
+    ctx->moved_buckets[b] = e;
+}
+
+void moved_from_free(ThreadContext *ctx) {
+    if (!ctx->moved_buckets) return;
+    for (int i = 0; i < INODE_BUCKETS; i++) {
+        PathEntry *e = ctx->moved_buckets[i];
+        while (e) {
+            PathEntry *next = e->next;
+            free(e->path);
+            free(e);
+            e = next;
+        }
+    }
+    free(ctx->moved_buckets);
+    ctx->moved_buckets = NULL;
+}
+
+// Look for an existing row on the same inode as a NEW path. Size and mtime
+// must match as well so a recycled inode number is not mistaken for the file.
+// Returns 1 with old_path set if that row's path no longer exists (a rename
+// or move), 2 if it still exists (a new hardlink), 0 if nothing matched.
+// In both matching cases the row's checksum is copied into d, and for a
+// hardlink its chunk digests and keywords as well.
+int find_by_inode(ThreadContext *ctx, sqlite3 *db, const char *path, const struct stat *st,
+                  char *old_path, FileDigest *d) {
+    sqlite3_stmt *stmt;
+    int found = 0;
+    // Unary + keeps the planner on files_inode: files_size can match most of
+    // the table (e.g. thousands of empty files)
+    if (sqlite3_prepare_v2(db, "SELECT full_path, checksum, chunk_hashes, keywords FROM files WHERE inode = ? AND device = ? AND +size = ? AND +last_modified = ?", -1, &stmt, NULL) != SQLITE_OK) return 0;
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)st->st_ino);
+    sqlite3_bind_int64(stmt, 2, (sqlite3_int64)st->st_dev);
+    sqlite3_bind_int64(stmt, 3, st->st_size);
+    sqlite3_bind_int64(stmt, 4, st->st_mtime);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *dp = (const char *)sqlite3_column_text(stmt, 0);
+        const char *dc = (const char *)sqlite3_column_text(stmt, 1);
+        if (!dp || !dc || strcmp(dp, path) == 0) continue;
+
+        if (access(dp, F_OK) != 0) {
+            if (was_moved_from(ctx, dp)) continue;
+            snprintf(old_path, MAX_PATH, "%s", dp);
+            snprintf(d->checksum, HASH_SIZE, "%s", dc);
+            found = 1;
+            break;
+        }
+        if (!found) {
+            snprintf(d->checksum, HASH_SIZE, "%s", dc);
+            int len = sqlite3_column_bytes(stmt, 2);
+            if (len > 0 && len % CHUNK_DIGEST_SIZE == 0 && (d->chunks = malloc(len))) {
+                memcpy(d->chunks, sqlite3_column_blob(stmt, 2), len);
+                d->chunk_count = len / CHUNK_DIGEST_SIZE;
+            }
+            const char *keywords = (const char *)sqlite3_column_text(stmt, 3);
+            if (keywords) d->keywords = strdup(keywords);
+            found = 2;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+// A NEW path whose inode has a row in another shard of the root: a hardlink
+// to a file with another name, or a rename that changed the shard. Either
+// way that row's checksum saves reading the file. The path is still inserted
+// as NEW in this shard, where its name belongs; pair_across_shards matches a
+// rename with the old row once every shard has been scanned. The other
+// shards' connections are only read here.
+int find_in_other_shards(ThreadContext *ctx, const char *path, const struct stat *st, FileDigest *d) {
+    char old_path[MAX_PATH];
+    for (int k = 0; k < ctx->root->shard_count; k++) {
+        ThreadContext *other = &ctx->root->shards[k];
+        if (other == ctx) continue;
+        int found = find_by_inode(ctx, other->db, path, st, old_path, d);
+        if (found) return found;
+    }
+    return 0;
+}
+
+void record_move(ThreadContext *ctx, sqlite3 *db, const char *old_path, const char *path, const char *name,
+                 const struct stat *st, const char *checksum) {
+    char msg[MAX_PATH * 2 + 8];
+    snprintf(msg, sizeof(msg), "%s -> %s", old_path, path);
+    log_message(ctx, "MOVED", msg);
+    list_change(ctx, ctx->changes_fp, path);
+    list_change(ctx, ctx->deletes_fp, old_path);
+
+    add_moved_from(ctx, old_path);
+
+    if (update) {
+        sqlite3_stmt *mv_stmt;
+        sqlite3_prepare_v2(db, "UPDATE files SET file_name = ?, full_path = ?, size = ?, last_modified = ?, checksum = ?, device = ?, inode = ? WHERE full_path = ?", -1, &mv_stmt, NULL);
+        sqlite3_bind_text(mv_stmt, 1, name, -1, SQLITE_STATIC);
+        sqlite3_bind_text(mv_stmt, 2, path, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(mv_stmt, 3, st->st_size);
+        sqlite3_bind_int64(mv_stmt, 4, st->st_mtime);
+        sqlite3_bind_text(mv_stmt, 5, checksum, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(mv_stmt, 6, (sqlite3_int64)st->st_dev);
+        sqlite3_bind_int64(mv_stmt, 7, (sqlite3_int64)st->st_ino);
+        sqlite3_bind_text(mv_stmt, 8, old_path, -1, SQLITE_STATIC);
+        sqlite3_step(mv_stmt);
+        sqlite3_finalize(mv_stmt);
+    }
+    ctx->moved++;
+}
+
 // ==== Core Logic ====
 void process_file(ThreadContext *ctx, const char *path, const char *name, sqlite3 *db) {
     struct stat st;
     if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return;
 
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db, "SELECT last_modified, checksum FROM files WHERE full_path = ? LIMIT 1", -1, &stmt, NULL);
+    int rc = sqlite3_prepare_v2(db, "SELECT last_modified, checksum, device, inode FROM files WHERE full_path = ? LIMIT 1", -1, &stmt, NULL);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "SQLite prepare error: %s\n", sqlite3_errmsg(db));
         ctx->error++;
@@ -208,51 +1157,111 @@ void process_file(ThreadContext *ctx, const char *path, const char *name, sqlite
         time_t db_mtime = sqlite3_column_int64(stmt, 0);
         const char *db_checksum = (const char *)sqlite3_column_text(stmt, 1);
         int mtime_match = (db_mtime == st.st_mtime);
+        int inode_match = sqlite3_column_type(stmt, 3) != SQLITE_NULL &&
+                          (dev_t)sqlite3_column_int64(stmt, 2) == st.st_dev &&
+                          (ino_t)sqlite3_column_int64(stmt, 3) == st.st_ino;
+
+        // Record the inode on rows written before it was tracked (or after a restore)
+        if (update && !inode_match) {
+            sqlite3_stmt *ino_stmt;
+            sqlite3_prepare_v2(db, "UPDATE files SET device = ?, inode = ? WHERE full_path = ?", -1, &ino_stmt, NULL);
+            sqlite3_bind_int64(ino_stmt, 1, (sqlite3_int64)st.st_dev);
+            sqlite3_bind_int64(ino_stmt, 2, (sqlite3_int64)st.st_ino);
+            sqlite3_bind_text(ino_stmt, 3, path, -1, SQLITE_STATIC);
+            sqlite3_step(ino_stmt);
+            sqlite3_finalize(ino_stmt);
+        }
 
         if (!verifyChecksum && mtime_match) {
             log_message(ctx, "UNCHANGED", path);
             ctx->unchanged++;
         } else {
-            char checksum[HASH_SIZE];
-            compute_sha256(path, checksum);
-            int checksum_match = (db_checksum && strcmp(checksum, db_checksum) == 0);
+            // A -c recheck hashes in the stored format, since a plain SHA-256
+            // and a tree hash never match (even if only the mtime changed).
+            // Content that changed is stored in this run's format, which
+            // takes a second read if the formats differ.
+            FileDigest digest;
+            int chunk_mib = verifyChecksum ? checksum_chunk_mib(db_checksum) : chunkMiB;
+            hash_file(ctx, path, &st, chunk_mib, &digest);
+            int checksum_match = (db_checksum && strcmp(digest.checksum, db_checksum) == 0);
+            int run_mib = (chunkMiB > 0 && st.st_size > ((long long)chunkMiB << 20)) ? chunkMiB : 0;
+            if (update && !checksum_match && digest.checksum[0] && checksum_chunk_mib(digest.checksum) != run_mib) {
+                digest_free(&digest);
+                hash_file(ctx, path, &st, chunkMiB, &digest);
+            }
 
             if (verifyChecksum && checksum_match) {
                 log_message(ctx, "UNCHANGED", path);
                 ctx->unchanged++;
+                // -c -K fills in keywords for files tracked before -K was used
+                if (update && digest.keywords) {
+                    sqlite3_stmt *kw_stmt;
+                    sqlite3_prepare_v2(db, "UPDATE files SET keywords = ? WHERE full_path = ? AND keywords IS NOT ?", -1, &kw_stmt, NULL);
+                    sqlite3_bind_text(kw_stmt, 1, digest.keywords, -1, SQLITE_STATIC);
+                    sqlite3_bind_text(kw_stmt, 2, path, -1, SQLITE_STATIC);
+                    sqlite3_bind_text(kw_stmt, 3, digest.keywords, -1, SQLITE_STATIC);
+                    sqlite3_step(kw_stmt);
+                    sqlite3_finalize(kw_stmt);
+                }
             } else {
                 log_message(ctx, (!mtime_match) ? "CHANGED (Metadata)" : "CHANGED (Checksum)", path);
+                list_change(ctx, ctx->changes_fp, path);
                 if (update) {
                     sqlite3_stmt *up_stmt;
-                    sqlite3_prepare_v2(db, "UPDATE files SET checksum = ?, last_modified = ? WHERE full_path = ?", -1, &up_stmt, NULL);
-                    sqlite3_bind_text(up_stmt, 1, checksum, -1, SQLITE_STATIC);
+                    sqlite3_prepare_v2(db, "UPDATE files SET checksum = ?, last_modified = ?, size = ?, chunk_hashes = ?, keywords = ? WHERE full_path = ?", -1, &up_stmt, NULL);
+                    sqlite3_bind_text(up_stmt, 1, digest.checksum, -1, SQLITE_STATIC);
                     sqlite3_bind_int64(up_stmt, 2, st.st_mtime);
-                    sqlite3_bind_text(up_stmt, 3, path, -1, SQLITE_STATIC);
+                    sqlite3_bind_int64(up_stmt, 3, st.st_size);
+                    bind_chunks(up_stmt, 4, &digest);
+                    sqlite3_bind_text(up_stmt, 5, digest.keywords, -1, SQLITE_STATIC);
+                    sqlite3_bind_text(up_stmt, 6, path, -1, SQLITE_STATIC);
                     sqlite3_step(up_stmt);
                     sqlite3_finalize(up_stmt);
                 }
                 ctx->changed++;
             }
+            digest_free(&digest);
         }
     } else {
-        log_message(ctx, "NEW", path);
-        if (update) {
-            char checksum[HASH_SIZE], owner[256];
-            compute_sha256(path, checksum);
-            get_owner(st.st_uid, owner, sizeof(owner));
-            sqlite3_stmt *ins_stmt;
-            sqlite3_prepare_v2(db, "INSERT INTO files (file_name, full_path, size, created, last_modified, owner, checksum) VALUES (?, ?, ?, ?, ?, ?, ?)", -1, &ins_stmt, NULL);
-            sqlite3_bind_text(ins_stmt, 1, name, -1, SQLITE_STATIC);
-            sqlite3_bind_text(ins_stmt, 2, path, -1, SQLITE_STATIC);
-            sqlite3_bind_int64(ins_stmt, 3, st.st_size);
-            sqlite3_bind_int64(ins_stmt, 4, st.st_ctime);
-            sqlite3_bind_int64(ins_stmt, 5, st.st_mtime);
-            sqlite3_bind_text(ins_stmt, 6, owner, -1, SQLITE_STATIC);
-            sqlite3_bind_text(ins_stmt, 7, checksum, -1, SQLITE_STATIC);
-            sqlite3_step(ins_stmt);
-            sqlite3_finalize(ins_stmt);
-        }
-        ctx->new++;
+        char old_path[MAX_PATH];
+        FileDigest digest;
+        memset(&digest, 0, sizeof(digest));
+        int inode_found = find_by_inode(ctx, db, path, &st, old_path, &digest);
+        int moved = (inode_found == 1);
+        if (!inode_found && ctx->root) inode_found = find_in_other_shards(ctx, path, &st, &digest);
+
+        // A new hardlink (inode_found == 2) or a rename from another shard
+        // already has its checksum. A move across filesystems is inserted as
+        // NEW and paired by find_missing (or pair_across_shards).
+        if (!inode_found && update) hash_file(ctx, path, &st, chunkMiB, &digest);
+
+        if (moved) {
+            record_move(ctx, db, old_path, path, name, &st, digest.checksum);
+        } else {
+            log_message(ctx, "NEW", path);
+            list_change(ctx, ctx->changes_fp, path);
+            if (update) {
+                char owner[256];
+                get_owner(st.st_uid, owner, sizeof(owner));
+                sqlite3_stmt *ins_stmt;
+                sqlite3_prepare_v2(db, "INSERT INTO files (file_name, full_path, size, created, last_modified, owner, checksum, device, inode, chunk_hashes, keywords) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)", -1, &ins_stmt, NULL);
+                sqlite3_bind_text(ins_stmt, 1, name, -1, SQLITE_STATIC);
+                sqlite3_bind_text(ins_stmt, 2, path, -1, SQLITE_STATIC);
+                sqlite3_bind_int64(ins_stmt, 3, st.st_size);
+                sqlite3_bind_int64(ins_stmt, 4, st.st_ctime);
+                sqlite3_bind_int64(ins_stmt, 5, st.st_mtime);
+                sqlite3_bind_text(ins_stmt, 6, owner, -1, SQLITE_STATIC);
+                sqlite3_bind_text(ins_stmt, 7, digest.checksum, -1, SQLITE_STATIC);
+                sqlite3_bind_int64(ins_stmt, 8, (sqlite3_int64)st.st_dev);
+                sqlite3_bind_int64(ins_stmt, 9, (sqlite3_int64)st.st_ino);
+                bind_chunks(ins_stmt, 10, &digest);
+                sqlite3_bind_text(ins_stmt, 11, digest.keywords, -1, SQLITE_STATIC);
+                sqlite3_step(ins_stmt);
+                sqlite3_finalize(ins_stmt);
+            }
+            ctx->new++;
+        }
+        digest_free(&digest);
     }
     sqlite3_finalize(stmt);
 
@@ -265,6 +1274,50 @@ void process_file(ThreadContext *ctx, const char *path, const char *name, sqlite
     }
 }
 
+// ==== Sharding ====
+// Shards are chosen by file name rather than full path, so a file moved to
+// another directory stays in the same shard and is still matched as MOVED.
+void shard_dispatch(ThreadContext *ctx, const char *path, const char *name) {
+    ShardQueue *q = ctx->shards[string_hash(name) % ctx->shard_count].queue;
+    char *copy = strdup(path);
+    pthread_mutex_lock(&q->mutex);
+    while (q->count == SHARD_QUEUE_SIZE) pthread_cond_wait(&q->not_full, &q->mutex);
+    q->paths[(q->head + q->count) % SHARD_QUEUE_SIZE] = copy;
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+// Returns the next path to process, or NULL once the traversal is done
+char *shard_next(ShardQueue *q) {
+    pthread_mutex_lock(&q->mutex);
+    while (q->count == 0 && !q->closed) pthread_cond_wait(&q->not_empty, &q->mutex);
+    char *path = NULL;
+    if (q->count > 0) {
+        path = q->paths[q->head];
+        q->head = (q->head + 1) % SHARD_QUEUE_SIZE;
+        q->count--;
+        pthread_cond_signal(&q->not_full);
+    }
+    pthread_mutex_unlock(&q->mutex);
+    return path;
+}
+
+void shard_close(ShardQueue *q) {
+    pthread_mutex_lock(&q->mutex);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+// Shard 0 is <name>.db itself and holds meta/metadata for the whole root;
+// shard k > 0 is <name>.shard<k>.db
+void shard_db_path(const char *db_path, int k, char *out) {
+    size_t len = strlen(db_path);
+    if (k == 0) snprintf(out, MAX_PATH, "%s", db_path);
+    else snprintf(out, MAX_PATH, "%.*s.shard%d.db", (int)(len - 3), db_path, k);
+}
+
 void traverse_directory(ThreadContext *ctx, const char *dir_path, sqlite3 *db) {
     DIR *dir = opendir(dir_path);
     if (!dir) return;
@@ -288,6 +1341,8 @@ void traverse_directory(ThreadContext *ctx, const char *dir_path, sqlite3 *db) {
                 traverse_directory(ctx, full_path, db);
             } else if (strcmp(entry->d_name, ".DS_Store") == 0 || strcmp(entry->d_name, "LastSyncDate") == 0) {
                 ctx->ignored++;
+            } else if (ctx->shard_count > 1) {
+                shard_dispatch(ctx, full_path, entry->d_name);
             } else {
                 process_file(ctx, full_path, entry->d_name, db);
             }
@@ -296,15 +1351,72 @@ void traverse_directory(ThreadContext *ctx, const char *dir_path, sqlite3 *db) {
     closedir(dir);
 }
 
-void *path_worker(void *arg) {
-    ThreadContext *ctx = (ThreadContext *)arg;
-    sqlite3 *db;
+// Id of the next row to be inserted, so this run's NEW rows can be told apart
+sqlite3_int64 next_row_id(sqlite3 *db) {
+    sqlite3_stmt *stmt;
+    sqlite3_int64 id = 1;
+    if (sqlite3_prepare_v2(db, "SELECT coalesce(max(id), 0) + 1 FROM files", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) id = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    return id;
+}
 
-    if (sqlite3_open(ctx->db_path, &db) != SQLITE_OK) {
-        fprintf(stderr, "Error: Failed to open database %s\n", ctx->db_path);
+// A shard comes with its root's inode cache already set, so a hardlink is
+// hashed once however its names are spread over the shards
+int init_run_state(ThreadContext *ctx) {
+    int own_inodes = !ctx->inode_buckets;
+    if (own_inodes) ctx->inode_buckets = calloc(INODE_BUCKETS, sizeof(InodeEntry *));
+    ctx->moved_buckets = calloc(INODE_BUCKETS, sizeof(PathEntry *));
+    if (!ctx->inode_buckets || !ctx->moved_buckets) {
+        fprintf(stderr, "Error: Out of memory for %s\n", ctx->source_path);
+        if (own_inodes) {
+            free(ctx->inode_buckets);
+            ctx->inode_buckets = NULL;
+        }
+        free(ctx->moved_buckets);
+        ctx->moved_buckets = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// -K: full-text index over files.keywords (an FTS5 external content table),
+// kept in step by triggers so deletes and non -K runs cannot leave it stale.
+// Without FTS5 the keywords are still stored and file_locator -q uses LIKE.
+void create_content_index(sqlite3 *db) {
+    sqlite3_stmt *stmt;
+    int exists = 0;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE name = 'files_fts'", -1, &stmt, NULL) == SQLITE_OK) {
+        exists = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_finalize(stmt);
+    }
+    if (exists) return;
+    if (sqlite3_exec(db, "CREATE VIRTUAL TABLE files_fts USING fts5(keywords, content='files', content_rowid='id');", 0, 0, 0) != SQLITE_OK) {
+        fprintf(stderr, "Warning: No full-text index (FTS5 unavailable): %s\n", sqlite3_errmsg(db));
+        return;
+    }
+    sqlite3_exec(db, "CREATE TRIGGER files_fts_insert AFTER INSERT ON files WHEN new.keywords IS NOT NULL BEGIN "
+                     "INSERT INTO files_fts (rowid, keywords) VALUES (new.id, new.keywords); END;", 0, 0, 0);
+    sqlite3_exec(db, "CREATE TRIGGER files_fts_delete AFTER DELETE ON files WHEN old.keywords IS NOT NULL BEGIN "
+                     "INSERT INTO files_fts (files_fts, rowid, keywords) VALUES ('delete', old.id, old.keywords); END;", 0, 0, 0);
+    sqlite3_exec(db, "CREATE TRIGGER files_fts_update AFTER UPDATE OF keywords ON files BEGIN "
+                     "INSERT INTO files_fts (files_fts, rowid, keywords) SELECT 'delete', old.id, old.keywords WHERE old.keywords IS NOT NULL; "
+                     "INSERT INTO files_fts (rowid, keywords) SELECT new.id, new.keywords WHERE new.keywords IS NOT NULL; END;", 0, 0, 0);
+    sqlite3_exec(db, "INSERT INTO files_fts (files_fts) VALUES ('rebuild');", 0, 0, 0);
+}
+
+// Open a tracker database (or shard), bring its schema up to date and start
+// the run's transaction
+sqlite3 *open_tracker_db(ThreadContext *ctx, const char *db_path) {
+    sqlite3 *db;
+    // Serialized: shard writers also read each other's connections
+    if (sqlite3_open_v2(db_path, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Error: Failed to open database %s\n", db_path);
         if (ctx->log_fp) {
             fprintf(ctx->log_fp, "FATAL ERROR: Could not open database\n");
         }
+        sqlite3_close(db);
         return NULL;
     }
 
@@ -313,57 +1425,349 @@ void *path_worker(void *arg) {
     sqlite3_exec(db, "PRAGMA synchronous=NORMAL;", 0, 0, 0);
     sqlite3_busy_timeout(db, 30000);  // Increased timeout for concurrent access
 
-    sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS files (id INTEGER PRIMARY KEY, file_name TEXT, full_path TEXT UNIQUE, size INTEGER, created INTEGER, last_modified INTEGER, owner TEXT, checksum TEXT, keywords TEXT);", 0, 0, 0);
-    sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS meta (id INTEGER PRIMARY KEY AUTOINCREMENT, last_checksum_verify_date TEXT, last_date_verify TEXT, verify_machine TEXT, num_unchanged INTEGER, num_changed INTEGER, num_new INTEGER, num_missing INTEGER, num_errors INTEGER, update_mode TEXT);", 0, 0, 0);
+    sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS files (id INTEGER PRIMARY KEY, file_name TEXT, full_path TEXT UNIQUE, size INTEGER, created INTEGER, last_modified INTEGER, owner TEXT, checksum TEXT, keywords TEXT, device INTEGER, inode INTEGER, chunk_hashes BLOB);", 0, 0, 0);
+    sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS meta (id INTEGER PRIMARY KEY AUTOINCREMENT, last_checksum_verify_date TEXT, last_date_verify TEXT, verify_machine TEXT, num_unchanged INTEGER, num_changed INTEGER, num_new INTEGER, num_missing INTEGER, num_errors INTEGER, update_mode TEXT, num_moved INTEGER, scan_seconds REAL, file_count INTEGER, total_bytes INTEGER, bytes_hashed INTEGER);", 0, 0, 0);
+
+    // Migrate: add update_mode to meta tables created before it existed.
+    // Fails harmlessly with "duplicate column name" once the column is present.
+    sqlite3_exec(db, "ALTER TABLE meta ADD COLUMN update_mode TEXT;", 0, 0, 0);
+    sqlite3_exec(db, "ALTER TABLE meta ADD COLUMN num_moved INTEGER;", 0, 0, 0);
+    sqlite3_exec(db, "ALTER TABLE meta ADD COLUMN scan_seconds REAL;", 0, 0, 0);
+    sqlite3_exec(db, "ALTER TABLE meta ADD COLUMN file_count INTEGER;", 0, 0, 0);
+    sqlite3_exec(db, "ALTER TABLE meta ADD COLUMN total_bytes INTEGER;", 0, 0, 0);
+    sqlite3_exec(db, "ALTER TABLE meta ADD COLUMN bytes_hashed INTEGER;", 0, 0, 0);
+    sqlite3_exec(db, "ALTER TABLE files ADD COLUMN device INTEGER;", 0, 0, 0);
+    sqlite3_exec(db, "ALTER TABLE files ADD COLUMN inode INTEGER;", 0, 0, 0);
+    sqlite3_exec(db, "ALTER TABLE files ADD COLUMN chunk_hashes BLOB;", 0, 0, 0);
+    // Lookups used to match NEW paths against renamed/moved rows
+    sqlite3_exec(db, "CREATE INDEX IF NOT EXISTS files_inode ON files (inode);", 0, 0, 0);
+    sqlite3_exec(db, "CREATE INDEX IF NOT EXISTS files_size ON files (size);", 0, 0, 0);
+    sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS metadata (key TEXT PRIMARY KEY, value TEXT);", 0, 0, 0);
+    if (contentIndex) create_content_index(db);
 
     // Begin transaction for better performance and reduced lock contention
     sqlite3_exec(db, "BEGIN TRANSACTION;", 0, 0, 0);
+    return db;
+}
+
+// Rows are placed by shard count, so it cannot change once rows exist.
+// Databases written before sharding have no "shards" key and count as 1.
+int check_shard_layout(ThreadContext *ctx, sqlite3 *db) {
+    int stored = 0;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT value FROM metadata WHERE key = 'shards'", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) stored = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    if (stored == 0 && sqlite3_prepare_v2(db, "SELECT 1 FROM files LIMIT 1", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) stored = 1;
+        sqlite3_finalize(stmt);
+    }
+    if (stored != 0 && stored != shardCount) {
+        fprintf(stderr, "Error: %s was created with %d shard(s); run with -S %d\n", ctx->db_path, stored, stored);
+        return -1;
+    }
+    return 0;
+}
 
-    if( showProgress ) printf("Beginning traversal of %s\n",ctx->source_path);
-    traverse_directory(ctx, ctx->source_path, db);
-    if( showProgress ) printf("Traversal of %s complete\n",ctx->source_path);
+// ==== Bloom Filters ====
+// Keys are "n:<file name>" and "c:<checksum>". Two 64-bit hashes of the key
+// (FNV-1a, then a splitmix64 finalizer) drive double hashing.
+// file_locator.c has the matching lookup.
+void bloom_hash(char type, const char *key, uint64_t *h1, uint64_t *h2) {
+    uint64_t h = 1469598103934665603ULL;
+    h = (h ^ (unsigned char)type) * 1099511628211ULL;
+    h = (h ^ ':') * 1099511628211ULL;
+    for (const char *p = key; *p; p++) h = (h ^ (unsigned char)*p) * 1099511628211ULL;
+    *h1 = h;
+    h += 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    *h2 = (h ^ (h >> 31)) | 1;
+}
+
+Bloom *bloom_create(uint64_t keys) {
+    Bloom *b = calloc(1, sizeof(Bloom));
+    if (!b) return NULL;
+    uint64_t bits = keys * BLOOM_BITS_PER_KEY;
+    if (bits < 1024) bits = 1024;
+    bits = (bits + 63) & ~63ULL;
+    b->data = calloc(bits / 8, 1);
+    if (!b->data) {
+        free(b);
+        return NULL;
+    }
+    memcpy(b->header.magic, "FTBLOOM1", 8);
+    b->header.hashes = BLOOM_HASHES;
+    b->header.bits = bits;
+    return b;
+}
+
+void bloom_add(Bloom *b, char type, const char *key) {
+    if (!b || !key) return;
+    uint64_t h1, h2;
+    bloom_hash(type, key, &h1, &h2);
+    for (uint32_t i = 0; i < b->header.hashes; i++) {
+        uint64_t bit = (h1 + i * h2) % b->header.bits;
+        b->data[bit / 8] |= 1 << (bit % 8);
+    }
+    b->header.keys++;
+}
+
+void bloom_free(Bloom *b) {
+    if (!b) return;
+    free(b->data);
+    free(b);
+}
+
+// <name>.db -> <name>.bloom, written to a temporary file and renamed so a
+// reader never maps a partial filter. Called after the database is closed,
+// so a filter is only trusted while it is newer than the database.
+void bloom_write(Bloom *b, const char *db_path) {
+    char path[MAX_PATH], tmp_path[MAX_PATH + 8];
+    size_t len = strlen(db_path);
+    if (!b || len <= 3) return;
+    snprintf(path, sizeof(path), "%.*s.bloom", (int)(len - 3), db_path);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) {
+        fprintf(stderr, "Warning: Could not write %s: %s\n", tmp_path, strerror(errno));
+        return;
+    }
+    int ok = fwrite(&b->header, sizeof(b->header), 1, f) == 1 &&
+             fwrite(b->data, b->header.bits / 8, 1, f) == 1;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "Warning: Could not write %s: %s\n", path, strerror(errno));
+        unlink(tmp_path);
+    }
+}
+
+// A move across filesystems gets a new inode, so find_by_inode misses it and
+// the file is inserted as NEW. Pair a disappeared row with a row this run
+// inserted with the same size and checksum and fold the two into the old row,
+// renamed. Only disappeared rows are looked up, so a run where nothing went
+// missing does no work here. Empty files all share one checksum and are
+// never paired. Returns 1 if old_path was paired.
+int pair_moved_copy(ThreadContext *ctx, sqlite3 *db, const char *old_path, long long size, const char *checksum) {
+    if (size <= 0 || !checksum || !checksum[0]) return 0;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT id, file_name, full_path, last_modified, device, inode, chunk_hashes, keywords FROM files "
+                               "WHERE size = ? AND checksum = ? AND id >= ? LIMIT 1", -1, &stmt, NULL) != SQLITE_OK) return 0;
+    sqlite3_bind_int64(stmt, 1, size);
+    sqlite3_bind_text(stmt, 2, checksum, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 3, ctx->first_new_id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        sqlite3_finalize(stmt);
+        return 0;
+    }
+
+    // The NEW row gives way so its path can move onto the old row
+    char new_path[MAX_PATH];
+    snprintf(new_path, sizeof(new_path), "%s", (const char *)sqlite3_column_text(stmt, 2));
+    sqlite3_stmt *del, *mv;
+    sqlite3_prepare_v2(db, "DELETE FROM files WHERE id = ?", -1, &del, NULL);
+    sqlite3_bind_int64(del, 1, sqlite3_column_int64(stmt, 0));
+    sqlite3_prepare_v2(db, "UPDATE files SET file_name = ?, full_path = ?, last_modified = ?, device = ?, inode = ?, chunk_hashes = ?, keywords = ? WHERE full_path = ?", -1, &mv, NULL);
+    for (int c = 1; c <= 7; c++) sqlite3_bind_value(mv, c, sqlite3_column_value(stmt, c));
+    sqlite3_bind_text(mv, 8, old_path, -1, SQLITE_STATIC);
+    sqlite3_finalize(stmt);
+    sqlite3_step(del);
+    sqlite3_finalize(del);
+    int moved = sqlite3_step(mv) == SQLITE_DONE;
+    sqlite3_finalize(mv);
+
+    if (moved) {
+        char msg[MAX_PATH * 2 + 8];
+        snprintf(msg, sizeof(msg), "%s -> %s", old_path, new_path);
+        log_message(ctx, "MOVED", msg);
+        list_change(ctx, ctx->deletes_fp, old_path);
+        ctx->new--;
+        ctx->moved++;
+    }
+    return moved;
+}
 
-    char **missing_paths = NULL;
+void report_missing(ThreadContext *ctx, sqlite3 *db, const char *path) {
+    if( showProgress ) printf("Deleting missing files from the database\n");
+    ctx->missing++;
+    log_message(ctx, "MISSING", path);
+    list_change(ctx, ctx->deletes_fp, path);
+    if (update) {
+        sqlite3_stmt *dStmt;
+        sqlite3_prepare_v2(db, "DELETE FROM files WHERE full_path = ?", -1, &dStmt, NULL);
+        sqlite3_bind_text(dStmt, 1, path, -1, SQLITE_STATIC);
+        sqlite3_step(dStmt);
+        sqlite3_finalize(dStmt);
+    }
+    if( showProgress ) printf("Completed deleting missing files from the database\n");
+}
+
+// Report rows whose path no longer exists and, in update mode, delete them.
+// Also totals the rows and bytes that remain, and builds the database's
+// Bloom filter. Rows deleted here stay in the filter, which only costs a
+// false positive, so it covers the database before and after the commit.
+void find_missing(ThreadContext *ctx, sqlite3 *db) {
+    MissingRow *missing_rows = NULL;
     int missing_count = 0, missing_capacity = 0;
+    ctx->file_count = ctx->total_bytes = 0;
+
+    sqlite3_stmt *cStmt;
+    if (sqlite3_prepare_v2(db, "SELECT count(*) FROM files", -1, &cStmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(cStmt) == SQLITE_ROW) ctx->bloom = bloom_create(sqlite3_column_int64(cStmt, 0) * 2);
+        sqlite3_finalize(cStmt);
+    }
 
     if( showProgress ) printf("Beginning Database Update\n");
     sqlite3_stmt *mStmt;
-    sqlite3_prepare_v2(db, "SELECT full_path FROM files", -1, &mStmt, NULL);
+    sqlite3_prepare_v2(db, "SELECT full_path, size, file_name, checksum FROM files", -1, &mStmt, NULL);
     while (sqlite3_step(mStmt) == SQLITE_ROW) {
         const char *dp = (const char *)sqlite3_column_text(mStmt, 0);
-        if (access(dp, F_OK) != 0) {
+        bloom_add(ctx->bloom, 'n', (const char *)sqlite3_column_text(mStmt, 2));
+        bloom_add(ctx->bloom, 'c', (const char *)sqlite3_column_text(mStmt, 3));
+        int exists = (access(dp, F_OK) == 0);
+        if (exists || !update) {
+            ctx->file_count++;
+            ctx->total_bytes += sqlite3_column_int64(mStmt, 1);
+        }
+        if (!exists && !was_moved_from(ctx, dp)) {
             // Expand array if needed
             if (missing_count >= missing_capacity) {
                 missing_capacity = missing_capacity == 0 ? 32 : missing_capacity * 2;
-                missing_paths = realloc(missing_paths, missing_capacity * sizeof(char*));
+                missing_rows = realloc(missing_rows, missing_capacity * sizeof(MissingRow));
             }
-            missing_paths[missing_count++] = strdup(dp);
+            const char *dc = (const char *)sqlite3_column_text(mStmt, 3);
+            MissingRow *m = &missing_rows[missing_count++];
+            m->path = strdup(dp);
+            m->checksum = dc ? strdup(dc) : NULL;
+            m->size = sqlite3_column_int64(mStmt, 1);
         }
     }
     sqlite3_finalize(mStmt);
     if( showProgress ) printf("Datbase Update Complete\n");
 
-    // Now delete the collected missing paths
+    // Now delete the collected missing paths, unless this run inserted the
+    // same content elsewhere (a move to a new inode). A shard keeps the rest
+    // for pair_across_shards, as the move may have changed the shard.
+    int unpaired = 0;
     for (int i = 0; i < missing_count; i++) {
-        if( showProgress ) printf("Deleting missing files from the database\n");
-        ctx->missing++;
-        log_message(ctx, "MISSING", missing_paths[i]);
-        if (update) {
-            sqlite3_stmt *dStmt;
-            sqlite3_prepare_v2(db, "DELETE FROM files WHERE full_path = ?", -1, &dStmt, NULL);
-            sqlite3_bind_text(dStmt, 1, missing_paths[i], -1, SQLITE_STATIC);
-            sqlite3_step(dStmt);
-            sqlite3_finalize(dStmt);
+        MissingRow *m = &missing_rows[i];
+        if (update && pair_moved_copy(ctx, db, m->path, m->size, m->checksum)) {
+            free(m->path);
+            free(m->checksum);
+            continue;
+        }
+        if (update && ctx->root) {
+            missing_rows[unpaired++] = *m;
+            continue;
+        }
+        report_missing(ctx, db, m->path);
+        free(m->path);
+        free(m->checksum);
+    }
+    if (unpaired > 0) {
+        ctx->unpaired = missing_rows;
+        ctx->unpaired_count = unpaired;
+    } else {
+        free(missing_rows);
+    }
+}
+
+void unpaired_free(ThreadContext *ctx) {
+    for (int i = 0; i < ctx->unpaired_count; i++) {
+        free(ctx->unpaired[i].path);
+        free(ctx->unpaired[i].checksum);
+    }
+    free(ctx->unpaired);
+    ctx->unpaired = NULL;
+    ctx->unpaired_count = 0;
+}
+
+// Pair a row left unpaired in shard with a row another shard (other, number
+// k) inserted as NEW this run with the same size and checksum. The NEW row is
+// kept, since its name places it in that shard, and takes over the old row's
+// creation time and owner (and its chunk digests and keywords, if it has
+// none). claimed lists the NEW rows already paired, as id * MAX_SHARDS + k.
+int pair_with_shard(ThreadContext *shard, ThreadContext *other, int k, const MissingRow *m,
+                    long long *claimed, int *claimed_count) {
+    if (m->size <= 0 || !m->checksum || !m->checksum[0]) return 0;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(other->db, "SELECT id, full_path FROM files WHERE size = ? AND checksum = ? AND id >= ?", -1, &stmt, NULL) != SQLITE_OK) return 0;
+    sqlite3_bind_int64(stmt, 1, m->size);
+    sqlite3_bind_text(stmt, 2, m->checksum, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 3, other->first_new_id);
+    sqlite3_int64 new_id = 0;
+    char new_path[MAX_PATH];
+    while (!new_id && sqlite3_step(stmt) == SQLITE_ROW) {
+        long long key = sqlite3_column_int64(stmt, 0) * MAX_SHARDS + k;
+        int taken = 0;
+        for (int i = 0; i < *claimed_count && !taken; i++) taken = claimed[i] == key;
+        if (taken) continue;
+        new_id = sqlite3_column_int64(stmt, 0);
+        snprintf(new_path, sizeof(new_path), "%s", (const char *)sqlite3_column_text(stmt, 1));
+        claimed[(*claimed_count)++] = key;
+    }
+    sqlite3_finalize(stmt);
+    if (!new_id) return 0;
+
+    sqlite3_stmt *old, *mv, *del;
+    if (sqlite3_prepare_v2(shard->db, "SELECT created, owner, chunk_hashes, keywords FROM files WHERE full_path = ?", -1, &old, NULL) == SQLITE_OK) {
+        sqlite3_bind_text(old, 1, m->path, -1, SQLITE_STATIC);
+        if (sqlite3_step(old) == SQLITE_ROW &&
+            sqlite3_prepare_v2(other->db, "UPDATE files SET created = ?, owner = ?, chunk_hashes = coalesce(chunk_hashes, ?), keywords = coalesce(keywords, ?) WHERE id = ?", -1, &mv, NULL) == SQLITE_OK) {
+            for (int c = 0; c < 4; c++) sqlite3_bind_value(mv, c + 1, sqlite3_column_value(old, c));
+            sqlite3_bind_int64(mv, 5, new_id);
+            sqlite3_step(mv);
+            sqlite3_finalize(mv);
         }
-        free(missing_paths[i]);
-        if( showProgress ) printf("Completed deleting missing files from the database\n");
+        sqlite3_finalize(old);
     }
-    free(missing_paths);
+    sqlite3_prepare_v2(shard->db, "DELETE FROM files WHERE full_path = ?", -1, &del, NULL);
+    sqlite3_bind_text(del, 1, m->path, -1, SQLITE_STATIC);
+    sqlite3_step(del);
+    sqlite3_finalize(del);
+
+    char msg[MAX_PATH * 2 + 8];
+    snprintf(msg, sizeof(msg), "%s -> %s", m->path, new_path);
+    log_message(shard, "MOVED", msg);
+    list_change(shard, shard->deletes_fp, m->path);
+    shard->moved++;
+    other->new--;
+    return 1;
+}
 
+// A file renamed into another shard is inserted there as NEW (with the old
+// row's checksum, see find_in_other_shards) while its old row disappears from
+// its own shard. Once every shard has been scanned, pair each row the shards
+// could not pair themselves, and report the rest as MISSING. Runs on the
+// root's thread, after the shard writers have finished.
+void pair_across_shards(ThreadContext *root) {
+    int total = 0, claimed_count = 0;
+    for (int k = 0; k < root->shard_count; k++) total += root->shards[k].unpaired_count;
+    long long *claimed = total > 0 ? malloc(total * sizeof(long long)) : NULL;
+
+    for (int k = 0; k < root->shard_count; k++) {
+        ThreadContext *shard = &root->shards[k];
+        for (int i = 0; i < shard->unpaired_count; i++) {
+            const MissingRow *m = &shard->unpaired[i];
+            int paired = 0;
+            for (int j = 0; claimed && j < root->shard_count && !paired; j++) {
+                if (j != k) paired = pair_with_shard(shard, &root->shards[j], j, m, claimed, &claimed_count);
+            }
+            if (!paired) report_missing(shard, shard->db, m->path);
+        }
+        unpaired_free(shard);
+    }
+    free(claimed);
+}
+
+// Append the run to meta and refresh the metadata key/value table
+void record_run(ThreadContext *ctx, sqlite3 *db, double duration_seconds) {
     char hname[256];
     gethostname(hname, 256);
     char *sql;
-    asprintf(&sql, "INSERT INTO meta (%s, verify_machine, num_unchanged, num_changed, num_new, num_missing, num_errors, update_mode) VALUES (datetime('now','localtime'), ?, ?, ?, ?, ?, ?, ?)",
+    asprintf(&sql, "INSERT INTO meta (%s, verify_machine, num_unchanged, num_changed, num_new, num_missing, num_errors, update_mode, num_moved, scan_seconds, file_count, total_bytes, bytes_hashed) VALUES (datetime('now','localtime'), ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
              verifyChecksum ? "last_checksum_verify_date" : "last_date_verify");
     sqlite3_stmt *insMeta;
     sqlite3_prepare_v2(db, sql, -1, &insMeta, NULL);
@@ -374,16 +1778,218 @@ void *path_worker(void *arg) {
     sqlite3_bind_int(insMeta, 5, ctx->missing);
     sqlite3_bind_int(insMeta, 6, ctx->error);
     sqlite3_bind_text(insMeta, 7, update ? "ON" : "OFF", -1, SQLITE_STATIC);
+    sqlite3_bind_int(insMeta, 8, ctx->moved);
+    sqlite3_bind_double(insMeta, 9, duration_seconds);
+    sqlite3_bind_int64(insMeta, 10, ctx->file_count);
+    sqlite3_bind_int64(insMeta, 11, ctx->total_bytes);
+    sqlite3_bind_int64(insMeta, 12, ctx->bytes_hashed);
     sqlite3_step(insMeta);
     sqlite3_finalize(insMeta);
     free(sql);
 
-    // Commit transaction
-    if( showProgress ) printf("Commiting Database Transaction\n");
-    sqlite3_exec(db, "COMMIT;", 0, 0, 0);
-    if( showProgress ) printf("Database Transaction Commit Complete\n");
+    char duration[32];
+    snprintf(duration, sizeof(duration), "%.1f", duration_seconds);
+
+    set_metadata_now(db, "last_run");
+    if (verifyChecksum) set_metadata_now(db, "last_verify");
+    set_metadata(db, "verify_machine", hname);
+    set_metadata(db, "update_mode", update ? "ON" : "OFF");
+    set_metadata(db, "scan_seconds", duration);
+    set_metadata_int(db, "shards", shardCount);
+    if (ctx->run_id[0]) set_metadata(db, "run_id", ctx->run_id);
+    set_metadata_int(db, "file_count", ctx->file_count);
+    set_metadata_int(db, "total_bytes", ctx->total_bytes);
+    set_metadata_int(db, "num_unchanged", ctx->unchanged);
+    set_metadata_int(db, "num_changed", ctx->changed);
+    set_metadata_int(db, "num_new", ctx->new);
+    set_metadata_int(db, "num_missing", ctx->missing);
+    set_metadata_int(db, "num_moved", ctx->moved);
+    set_metadata_int(db, "num_errors", ctx->error);
+}
+
+void *shard_worker(void *arg) {
+    ThreadContext *shard = (ThreadContext *)arg;
+    char *path;
+    while ((path = shard_next(shard->queue)) != NULL) {
+        const char *slash = strrchr(path, '/');
+        process_file(shard, path, slash ? slash + 1 : path, shard->db);
+        free(path);
+    }
+    find_missing(shard, shard->db);
+    return NULL;
+}
+
+// Traverse the root once, with one writer thread (and connection) per shard.
+// Shard 0 uses the root's own connection, which the caller commits after
+// recording the run.
+//
+// The shards are separate databases, so their commits cannot be made atomic
+// (attaching them to one connection would not help in WAL mode). Instead
+// every shard is stamped with the same run_id and shards 1..n are committed
+// before shard 0. A run that fails or crashes in between leaves shard 0 on
+// the previous run_id, and the readers refuse or skip a shard whose run_id
+// differs from it. The next run brings the shards back in step.
+int run_sharded(ThreadContext *ctx, sqlite3 *db) {
+    ThreadContext *shards = calloc(shardCount, sizeof(ThreadContext));
+    pthread_t threads[MAX_SHARDS];
+    int started = 0, rc = 0;
+    if (!shards) return -1;
+    snprintf(ctx->run_id, sizeof(ctx->run_id), "%lld-%d", (long long)time(NULL), (int)getpid());
+
+    for (int k = 0; k < shardCount; k++) {
+        ThreadContext *shard = &shards[k];
+        char shard_path[MAX_PATH];
+        memcpy(shard->source_path, ctx->source_path, sizeof(shard->source_path));
+        shard_db_path(ctx->db_path, k, shard_path);
+        snprintf(shard->db_path, sizeof(shard->db_path), "%s", shard_path);
+        shard->log_fp = ctx->log_fp;
+        shard->changes_fp = ctx->changes_fp;
+        shard->deletes_fp = ctx->deletes_fp;
+        shard->queue = calloc(1, sizeof(ShardQueue));
+        if (shard->queue) {
+            pthread_mutex_init(&shard->queue->mutex, NULL);
+            pthread_cond_init(&shard->queue->not_empty, NULL);
+            pthread_cond_init(&shard->queue->not_full, NULL);
+        }
+        shard->db = (k == 0) ? db : open_tracker_db(ctx, shard_path);
+        shard->root = ctx;
+        shard->inode_buckets = ctx->inode_buckets;
+        if (!shard->queue || !shard->db || init_run_state(shard) != 0) {
+            rc = -1;
+            break;
+        }
+        shard->first_new_id = next_row_id(shard->db);
+    }
+
+    if (rc == 0) {
+        ctx->shards = shards;
+        ctx->shard_count = shardCount;
+        for (int k = 0; k < shardCount; k++) {
+            if (pthread_create(&threads[k], NULL, shard_worker, &shards[k]) != 0) {
+                fprintf(stderr, "Error: Failed to create shard thread for %s: %s\n", ctx->source_path, strerror(errno));
+                rc = -1;
+                break;
+            }
+            started++;
+        }
+    }
+
+    if (rc == 0) {
+        if( showProgress ) printf("Beginning traversal of %s (%d shards)\n", ctx->source_path, shardCount);
+        traverse_directory(ctx, ctx->source_path, db);
+        if( showProgress ) printf("Traversal of %s complete\n", ctx->source_path);
+    }
+
+    for (int k = 0; k < started; k++) shard_close(shards[k].queue);
+    for (int k = 0; k < started; k++) pthread_join(threads[k], NULL);
+    if (rc == 0) pair_across_shards(ctx);
+
+    for (int k = 0; k < shardCount; k++) {
+        ThreadContext *shard = &shards[k];
+        ctx->unchanged += shard->unchanged;
+        ctx->changed += shard->changed;
+        ctx->new += shard->new;
+        ctx->missing += shard->missing;
+        ctx->moved += shard->moved;
+        ctx->error += shard->error;
+        ctx->file_count += shard->file_count;
+        ctx->total_bytes += shard->total_bytes;
+        ctx->bytes_hashed += shard->bytes_hashed;
+
+        if (k > 0 && shard->db) {
+            if (rc == 0) {
+                set_metadata(shard->db, "run_id", ctx->run_id);
+                if (sqlite3_exec(shard->db, "COMMIT;", 0, 0, 0) != SQLITE_OK) {
+                    fprintf(stderr, "Error: Failed to commit %s: %s\n", shard->db_path, sqlite3_errmsg(shard->db));
+                    rc = -1;
+                }
+            }
+            if (rc != 0) sqlite3_exec(shard->db, "ROLLBACK;", 0, 0, 0);
+            sqlite3_close(shard->db);
+            if (rc == 0) bloom_write(shard->bloom, shard->db_path);
+        }
+        // Shard 0 is the root's own database, closed by path_worker
+        if (k == 0 && rc == 0) {
+            ctx->bloom = shard->bloom;
+            shard->bloom = NULL;
+        }
+        bloom_free(shard->bloom);
+        if (shard->queue) {
+            pthread_mutex_destroy(&shard->queue->mutex);
+            pthread_cond_destroy(&shard->queue->not_empty);
+            pthread_cond_destroy(&shard->queue->not_full);
+            free(shard->queue);
+        }
+        // The inode cache is the root's, freed by path_worker
+        shard->inode_buckets = NULL;
+        moved_from_free(shard);
+        unpaired_free(shard);
+    }
+    free(shards);
+    ctx->shards = NULL;
+    ctx->shard_count = 0;
+    return rc;
+}
+
+void *path_worker(void *arg) {
+    ThreadContext *ctx = (ThreadContext *)arg;
+    sqlite3 *db;
+    struct timespec scan_start, scan_end;
+    clock_gettime(CLOCK_MONOTONIC, &scan_start);
+
+    if (init_run_state(ctx) != 0) return NULL;
+
+    db = open_tracker_db(ctx, ctx->db_path);
+    if (!db) {
+        inode_cache_free(ctx);
+        moved_from_free(ctx);
+        return NULL;
+    }
+
+    ctx->first_new_id = next_row_id(db);
+
+    if (check_shard_layout(ctx, db) != 0) {
+        if (ctx->log_fp) fprintf(ctx->log_fp, "FATAL ERROR: Shard count mismatch\n");
+        sqlite3_exec(db, "ROLLBACK;", 0, 0, 0);
+        sqlite3_close(db);
+        inode_cache_free(ctx);
+        moved_from_free(ctx);
+        return NULL;
+    }
+
+    open_change_lists(ctx);
+
+    int failed = 0;
+    if (shardCount > 1) {
+        failed = run_sharded(ctx, db) != 0;
+    } else {
+        if( showProgress ) printf("Beginning traversal of %s\n",ctx->source_path);
+        traverse_directory(ctx, ctx->source_path, db);
+        if( showProgress ) printf("Traversal of %s complete\n",ctx->source_path);
+        find_missing(ctx, db);
+    }
+
+    if (failed) {
+        if (ctx->log_fp) fprintf(ctx->log_fp, "FATAL ERROR: Could not write all shards\n");
+        sqlite3_exec(db, "ROLLBACK;", 0, 0, 0);
+    } else {
+        clock_gettime(CLOCK_MONOTONIC, &scan_end);
+        record_run(ctx, db, (scan_end.tv_sec - scan_start.tv_sec) + (scan_end.tv_nsec - scan_start.tv_nsec) / 1e9);
+
+        // Commit transaction
+        if( showProgress ) printf("Commiting Database Transaction\n");
+        sqlite3_exec(db, "COMMIT;", 0, 0, 0);
+        if( showProgress ) printf("Database Transaction Commit Complete\n");
+    }
 
     sqlite3_close(db);
+    if (!failed) bloom_write(ctx->bloom, ctx->db_path);
+    bloom_free(ctx->bloom);
+    ctx->bloom = NULL;
+    if (ctx->changes_fp) fclose(ctx->changes_fp);
+    if (ctx->deletes_fp) fclose(ctx->deletes_fp);
+    inode_cache_free(ctx);
+    moved_from_free(ctx);
     // Note: log_fp is now closed in main() to allow appending the summary
 
     pthread_mutex_lock(&global_count_mutex);
@@ -391,6 +1997,7 @@ void *path_worker(void *arg) {
     total_changed += ctx->changed;
     total_new += ctx->new;
     total_missing += ctx->missing;
+    total_moved += ctx->moved;
     total_ignored += ctx->ignored;
     total_error += ctx->error;
     pthread_mutex_unlock(&global_count_mutex);
@@ -398,6 +2005,34 @@ void *path_worker(void *arg) {
     return NULL;
 }
 
+// Each path's database, logs and change lists are named after its basename,
+// and the other tools find them by that name. Two paths with the same
+// basename would mix their rows in one database, so refuse to run.
+int check_database_names(const char *path_arg) {
+    char *names[64];
+    const char *paths[64];
+    int count = 0, clash = 0;
+    char *copy = strdup(path_arg);
+    for (char *token = strtok(copy, ","); token && count < 64 && !clash; token = strtok(NULL, ",")) {
+        char *path_copy = strdup(token);
+        names[count] = strdup(basename(path_copy));
+        paths[count] = token;
+        free(path_copy);
+        for (int j = 0; j < count; j++) {
+            if (strcmp(names[j], names[count]) == 0) {
+                fprintf(stderr, "Error: %s and %s would share database %s.db; rename one of them\n",
+                        paths[j], paths[count], names[count]);
+                clash = 1;
+                break;
+            }
+        }
+        count++;
+    }
+    for (int j = 0; j < count; j++) free(names[j]);
+    free(copy);
+    return clash ? -1 : 0;
+}
+
 int main(int argc, char *argv[]) {
 
     char *path_arg = NULL;
@@ -416,6 +2051,17 @@ int main(int argc, char *argv[]) {
         else if (strcmp(argv[i], "-P") == 0) showProgress = 1;
         else if (strcmp(argv[i], "-h") == 0) help_requested = 1;
         else if (strcmp(argv[i], "-s") == 0) showSummary = 1;
+        else if (strcmp(argv[i], "-L") == 0) writeChangeLists = 1;
+        else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) shardCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc) chunkMiB = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc) hashThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-read-rate") == 0 && i + 1 < argc) maxReadMB = atof(argv[++i]);
+        else if (strcmp(argv[i], "--max-iops") == 0 && i + 1 < argc) maxIops = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cpu-threads") == 0 && i + 1 < argc) cpuThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--psi-limit") == 0 && i + 1 < argc) psiLimit = atof(argv[++i]);
+        else if (strcmp(argv[i], "--idle") == 0) idlePriority = 1;
+        else if (strcmp(argv[i], "-K") == 0) contentIndex = 1;
+        else if (strcmp(argv[i], "-x") == 0) hashCache = 1;
     }
 
     if (help_requested == 1) {
@@ -426,6 +2072,18 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "  -v          Verbose output\n");
         fprintf(stderr, "  -P          Show progress percentage\n");
         fprintf(stderr, "  -s          Show summary\n");
+        fprintf(stderr, "  -L          Append NEW/CHANGED/MOVED and MISSING paths to rsync change lists\n");
+        fprintf(stderr, "  -S <num>    Split each path's database into num shards, one writer each (max %d)\n", MAX_SHARDS);
+        fprintf(stderr, "  -M <MiB>    Tree-hash files larger than MiB in MiB chunks, in parallel\n");
+        fprintf(stderr, "  -H <num>    Threads hashing the chunks of one file (default 4)\n");
+        fprintf(stderr, "  -K          Extract keywords (MIME type, top terms) from files as they are hashed\n");
+        fprintf(stderr, "  -x          Reuse and (with -u) store checksums in the %s xattr\n", HASH_XATTR);
+        fprintf(stderr, "  --max-read-rate <MB/s>  Limit the read rate of all hashing combined\n");
+        fprintf(stderr, "  --max-iops <num>        Limit hashing reads per second, counted per 128 KiB read\n");
+        fprintf(stderr, "  --cpu-threads <num>     Limit files or chunks hashed at once\n");
+        fprintf(stderr, "  --psi-limit <pct>       Slow the three limits above while I/O pressure (some avg10) exceeds pct\n");
+        fprintf(stderr, "                          (default 10); without any of them it has no effect\n");
+        fprintf(stderr, "  --idle                  Run with idle I/O priority and nice 19 (not PSI-driven)\n");
         exit(0);
     }
 
@@ -435,6 +2093,22 @@ int main(int argc, char *argv[]) {
         exit(1);
     }
 
+    if (shardCount < 1 || shardCount > MAX_SHARDS) {
+        fprintf(stderr, "Error: -S must be between 1 and %d\n", MAX_SHARDS);
+        exit(1);
+    }
+
+    if (chunkMiB < 0 || chunkMiB > 65536) {
+        fprintf(stderr, "Error: -M must be between 0 (off) and 65536 MiB\n");
+        exit(1);
+    }
+    if (hashThreads < 1) hashThreads = 1;
+    if (check_database_names(path_arg) != 0) exit(1);
+
+    throttle.byte_rate = maxReadMB * 1000000;
+    throttle.op_rate = maxIops;
+    if (idlePriority) enter_idle_priority();
+
     load_ignore_list();
     const char *home = getenv("HOME");
 
@@ -489,9 +2163,26 @@ int main(int argc, char *argv[]) {
         snprintf(contexts[thread_count].log_path, MAX_PATH, "%s/logs/FileTracker/%s-%s.log", home, base, timestamp);
 
         contexts[thread_count].log_fp = fopen(contexts[thread_count].log_path, "w");
+
+        snprintf(contexts[thread_count].changes_path, MAX_PATH, "%s/logs/FileTracker/%s.changes", home, base);
+        snprintf(contexts[thread_count].deletes_path, MAX_PATH, "%s/logs/FileTracker/%s.deletes", home, base);
+        contexts[thread_count].changes_fp = contexts[thread_count].deletes_fp = NULL;
         contexts[thread_count].unchanged = contexts[thread_count].changed = 0;
         contexts[thread_count].new = contexts[thread_count].missing = 0;
         contexts[thread_count].ignored = contexts[thread_count].error = 0;
+        contexts[thread_count].moved = 0;
+        contexts[thread_count].bytes_hashed = 0;
+        contexts[thread_count].inode_buckets = NULL;
+        contexts[thread_count].moved_buckets = NULL;
+        contexts[thread_count].shards = NULL;
+        contexts[thread_count].shard_count = 0;
+        contexts[thread_count].queue = NULL;
+        contexts[thread_count].db = NULL;
+        contexts[thread_count].bloom = NULL;
+        contexts[thread_count].root = NULL;
+        contexts[thread_count].unpaired = NULL;
+        contexts[thread_count].unpaired_count = 0;
+        contexts[thread_count].run_id[0] = '\0';
 
         if (pthread_create(&threads[thread_count], NULL, path_worker, &contexts[thread_count]) != 0) {
             fprintf(stderr, "Error: Failed to create thread for path %s: %s\n",
@@ -528,6 +2219,7 @@ int main(int argc, char *argv[]) {
     if( showSummary ) printf("Changed        : %'d\n", total_changed);
     if( showSummary ) printf("New            : %'d\n", total_new);
     if( showSummary ) printf("Missing        : %'d\n", total_missing);
+    if( showSummary ) printf("Moved          : %'d\n", total_moved);
     if( showSummary ) printf("Ignored        : %'d\n", total_ignored);
     if( showSummary ) printf("Errors         : %'d\n", total_error);
     if( showSummary ) printf("%s", summary_footer);
@@ -539,6 +2231,7 @@ int main(int argc, char *argv[]) {
             fprintf(contexts[i].log_fp, "Changed        : %d\n", total_changed);
             fprintf(contexts[i].log_fp, "New            : %d\n", total_new);
             fprintf(contexts[i].log_fp, "Missing        : %d\n", total_missing);
+            fprintf(contexts[i].log_fp, "Moved          : %d\n", total_moved);
             fprintf(contexts[i].log_fp, "Ignored        : %d\n", total_ignored);
             fprintf(contexts[i].log_fp, "Errors         : %d\n", total_error);
             fprintf(contexts[i].log_fp, "%s", summary_footer);
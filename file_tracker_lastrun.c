@@ -1,43 +1,153 @@
 #include <sqlite3.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <locale.h>
 
-int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        printf("Usage: %s <file_tracker.db>\n", argv[0]);
-        return 1;
-    }
+#define MAX_PATH 4096
+
+typedef struct {
+    char last_run[32];
+    char last_verify[32];
+    char machine[64];
+    long long file_count;
+    long long total_bytes;
+    double scan_seconds;
+    long long changed, new_files, missing, errors;
+} LastRun;
 
-    const char *dbpath = argv[1];
+// Read the metadata key/value table maintained by file_tracker.
+// Returns 1 if a last_run was found, 0 if not, -1 on error.
+int read_last_run(const char *dbpath, LastRun *lr) {
     sqlite3 *db;
+    memset(lr, 0, sizeof(*lr));
 
-    if (sqlite3_open(dbpath, &db) != SQLITE_OK) {
-        fprintf(stderr, "Cannot open database: %s\n", sqlite3_errmsg(db));
-        return 1;
+    if (sqlite3_open_v2(dbpath, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Cannot open database %s: %s\n", dbpath, sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return -1;
     }
-
-    const char *sql =
-        "SELECT value FROM metadata WHERE key='last_run';";
+    sqlite3_busy_timeout(db, 5000);
 
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-
+    int rc = sqlite3_prepare_v2(db, "SELECT key, value FROM metadata;", -1, &stmt, NULL);
     if (rc != SQLITE_OK) {
-        fprintf(stderr, "Error preparing SQL: %s\n", sqlite3_errmsg(db));
+        fprintf(stderr, "Error preparing SQL for %s: %s\n", dbpath, sqlite3_errmsg(db));
         sqlite3_close(db);
-        return 1;
+        return -1;
     }
 
-    rc = sqlite3_step(stmt);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *key = (const char *)sqlite3_column_text(stmt, 0);
+        const char *val = (const char *)sqlite3_column_text(stmt, 1);
+        if (!key || !val) continue;
 
-    if (rc == SQLITE_ROW) {
-        const unsigned char *val = sqlite3_column_text(stmt, 0);
-        printf("Last Run: %s\n", val);
-    } else {
-        printf("No last run information stored.\n");
+        if (strcmp(key, "last_run") == 0) snprintf(lr->last_run, sizeof(lr->last_run), "%s", val);
+        else if (strcmp(key, "last_verify") == 0) snprintf(lr->last_verify, sizeof(lr->last_verify), "%s", val);
+        else if (strcmp(key, "verify_machine") == 0) snprintf(lr->machine, sizeof(lr->machine), "%s", val);
+        else if (strcmp(key, "file_count") == 0) lr->file_count = atoll(val);
+        else if (strcmp(key, "total_bytes") == 0) lr->total_bytes = atoll(val);
+        else if (strcmp(key, "scan_seconds") == 0) lr->scan_seconds = atof(val);
+        else if (strcmp(key, "num_changed") == 0) lr->changed = atoll(val);
+        else if (strcmp(key, "num_new") == 0) lr->new_files = atoll(val);
+        else if (strcmp(key, "num_missing") == 0) lr->missing = atoll(val);
+        else if (strcmp(key, "num_errors") == 0) lr->errors = atoll(val);
     }
 
     sqlite3_finalize(stmt);
     sqlite3_close(db);
+    return lr->last_run[0] ? 1 : 0;
+}
+
+void print_last_run(const LastRun *lr) {
+    printf("Last Run: %s\n", lr->last_run);
+    printf("Last Verify: %s\n", lr->last_verify[0] ? lr->last_verify : "never");
+    printf("Machine: %s\n", lr->machine[0] ? lr->machine : "unknown");
+    printf("Files: %'lld\n", lr->file_count);
+    printf("Total Bytes: %'lld\n", lr->total_bytes);
+    printf("Scan Duration: %.1f s\n", lr->scan_seconds);
+    printf("Changed: %'lld  New: %'lld  Missing: %'lld  Errors: %'lld\n",
+           lr->changed, lr->new_files, lr->missing, lr->errors);
+}
+
+// Shards written by "file_tracker -S" (<name>.shard<k>.db) belong to <name>.db
+int is_shard_file(const char *name) {
+    const char *p = strstr(name, ".shard");
+    if (!p) return 0;
+    p += strlen(".shard");
+    if (*p < '0' || *p > '9') return 0;
+    while (*p >= '0' && *p <= '9') p++;
+    return strcmp(p, ".db") == 0;
+}
+
+// One line per database in $HOME/db/FileTracker
+int list_all(const char *db_dir) {
+    DIR *dir = opendir(db_dir);
+    if (!dir) {
+        fprintf(stderr, "Cannot open directory: %s\n", db_dir);
+        return 1;
+    }
+
+    int failures = 0;
+    printf("%-24s %-19s %-19s %12s %18s %9s %8s\n",
+           "Database", "Last Run", "Last Verify", "Files", "Bytes", "Seconds", "Errors");
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len <= 3 || strcmp(entry->d_name + len - 3, ".db") != 0) continue;
+        if (is_shard_file(entry->d_name)) continue;
+
+        char dbpath[MAX_PATH];
+        snprintf(dbpath, sizeof(dbpath), "%s/%s", db_dir, entry->d_name);
+
+        LastRun lr;
+        int rc = read_last_run(dbpath, &lr);
+        if (rc <= 0) {
+            printf("%-24.*s %s\n", (int)(len - 3), entry->d_name,
+                   rc == 0 ? "No last run information stored." : "ERROR");
+            failures++;
+            continue;
+        }
+        printf("%-24.*s %-19s %-19s %'12lld %'18lld %9.1f %'8lld\n",
+               (int)(len - 3), entry->d_name, lr.last_run,
+               lr.last_verify[0] ? lr.last_verify : "never",
+               lr.file_count, lr.total_bytes, lr.scan_seconds, lr.errors);
+    }
+    closedir(dir);
+    return failures > 0 ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    setlocale(LC_NUMERIC, "");
+
+    if (argc != 2) {
+        printf("Usage: %s <file_tracker.db>\n", argv[0]);
+        printf("       %s -a    (every database in $HOME/db/FileTracker)\n", argv[0]);
+        return 1;
+    }
+
+    if (strcmp(argv[1], "-a") == 0) {
+        const char *home = getenv("HOME");
+        if (!home) {
+            fprintf(stderr, "Error: HOME environment variable not set\n");
+            return 1;
+        }
+        char db_dir[MAX_PATH];
+        snprintf(db_dir, sizeof(db_dir), "%s/db/FileTracker", home);
+        return list_all(db_dir);
+    }
+
+    LastRun lr;
+    int rc = read_last_run(argv[1], &lr);
+    if (rc < 0) return 1;
+
+    if (rc == 1) {
+        print_last_run(&lr);
+    } else {
+        printf("No last run information stored.\n");
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,107 @@
+# file_tracker change lists, shared by backup-Desktop, backup-Documents,
+# doc_arch and daily_backup.sh. Source it after setting SOURCE_DIR and
+# CURSOR_FILE; it is not meant to be run on its own.
+#
+# "file_tracker -u -L -p <source>" appends the paths it found NEW/CHANGED/MOVED
+# and MISSING to NUL-separated lists. The lists are shared with every backup of
+# the same source and never consumed: each destination keeps its own cursor
+# ("<list id> <changes offset> <deletes offset> [anchor]") and reads only the
+# entries past it. Without a cursor for the current list id (first use, lists
+# restarted, or a file_tracker -u run without -L) it must do a full sync.
+# Run the backups after file_tracker has finished. Requires rsync >= 3.1.
+#
+# The lists only carry what file_tracker sees: regular files whose size or
+# mtime changed. Permission- or owner-only changes, empty directories and
+# symlinks reach a destination on its next full sync; remove its cursor file
+# to force one.
+
+TRACKER_LOGS="${HOME}/logs/FileTracker"
+LIST_NAME="$TRACKER_LOGS/$(basename "$SOURCE_DIR")"
+CHANGES_LIST="$LIST_NAME.changes"
+DELETES_LIST="$LIST_NAME.deletes"
+LIST_ID_FILE="$LIST_NAME.listid"
+
+# Names file_tracker skips never appear in the lists, so full syncs skip them
+# too; otherwise Base would differ depending on which kind of sync ran.
+# ~/.rsync-ignore holds one name per line, matched anywhere in the tree.
+RSYNC_EXCLUDES=(--exclude=.DS_Store --exclude=LastSyncDate)
+if [ -f "${HOME}/.rsync-ignore" ]; then
+    while IFS= read -r name || [ -n "$name" ]; do
+        name=${name%$'\r'}
+        [ -n "$name" ] && RSYNC_EXCLUDES+=("--exclude=$name")
+    done < "${HOME}/.rsync-ignore"
+fi
+
+list_id() {
+    [ -f "$LIST_ID_FILE" ] && cat "$LIST_ID_FILE"
+}
+
+# Bytes of whole entries in a list (a trailing partial entry is left for later)
+list_end() {
+    local end
+    end=$(wc -c < "$1" 2>/dev/null | tr -d ' ')
+    end=${end:-0}
+    while [ "$end" -gt 0 ] && [ -n "$(tail -c +"$end" "$1" | head -c 1 | tr -d '\0')" ]; do
+        end=$((end - 1))
+    done
+    echo "$end"
+}
+
+# Entries of list $1 between byte offsets $2 and $3, into file $4
+list_slice() {
+    tail -c +$(($2 + 1)) "$1" | head -c $(($3 - $2)) > "$4"
+}
+
+save_cursor() {
+    echo "$*" > "$CURSOR_FILE.tmp" && mv "$CURSOR_FILE.tmp" "$CURSOR_FILE"
+}
+
+# Load the cursor into CURSOR_ID, CHANGES_FROM, DELETES_FROM and CURSOR_ANCHOR,
+# and the current lists into CURRENT_ID, CHANGES_TO and DELETES_TO. Succeeds
+# only if the cursor belongs to the current lists, so the entries between it
+# and the ends cover everything since it was saved.
+read_cursor() {
+    CURRENT_ID=$(list_id)
+    CURSOR_ID="" CHANGES_FROM=0 DELETES_FROM=0 CURSOR_ANCHOR=""
+    [ -f "$CURSOR_FILE" ] && read -r CURSOR_ID CHANGES_FROM DELETES_FROM CURSOR_ANCHOR < "$CURSOR_FILE"
+    CHANGES_TO=$(list_end "$CHANGES_LIST")
+    DELETES_TO=$(list_end "$DELETES_LIST")
+    [ -n "$CURRENT_ID" ] && [ "$CURSOR_ID" = "$CURRENT_ID" ] && [ "$(list_id)" = "$CURRENT_ID" ] &&
+        [ "${CHANGES_FROM:-x}" -le "$CHANGES_TO" ] 2>/dev/null &&
+        [ "${DELETES_FROM:-x}" -le "$DELETES_TO" ] 2>/dev/null
+}
+
+# Note where the lists end before a full sync, so entries added during it are
+# synced again next time rather than skipped
+mark_full_sync() {
+    FULL_ID=$(list_id)
+    FULL_CHANGES=$(list_end "$CHANGES_LIST")
+    FULL_DELETES=$(list_end "$DELETES_LIST")
+}
+
+# After a successful full sync: start from the marked point of the lists
+# (if file_tracker keeps lists at all, and they were not restarted meanwhile).
+# An optional anchor is stored with the cursor for the caller's own use.
+finish_full_sync() {
+    if [ -n "$FULL_ID" ] && [ "$(list_id)" = "$FULL_ID" ]; then
+        save_cursor "$FULL_ID" "$FULL_CHANGES" "$FULL_DELETES" "$@"
+    else
+        rm -f "$CURSOR_FILE"
+    fi
+}
+
+# Remove the entries of deletes list $1 from mirror $2 if they are still gone
+# from the source (a path can be deleted and later recreated), along with any
+# directories that leaves empty and that no longer exist in the source
+remove_deleted() {
+    local f dir
+    while IFS= read -r -d '' f; do
+        [ -e "$SOURCE_DIR/$f" ] && continue
+        rm -f -- "$2/$f"
+        dir=$(dirname -- "$f")
+        while [ "$dir" != "." ] && [ "$dir" != "/" ] && [ ! -e "$SOURCE_DIR/$dir" ] &&
+              rmdir -- "$2/$dir" 2>/dev/null; do
+            dir=$(dirname -- "$dir")
+        done
+    done < "$1"
+}
@@ -0,0 +1,562 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <locale.h>
+#include <pthread.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+#ifdef __APPLE__
+#include <sys/clonefile.h>
+#define st_atim st_atimespec
+#define st_mtim st_mtimespec
+#endif
+
+#define HASH_SIZE 80     // "m<chunk MiB>:" + 64 hex digits for tree hashes
+#define MAX_PATH 4096
+#define MAX_SHARDS 8
+#define COPY_ATTEMPTS 3     // copies of a file that keeps changing under us
+
+// ==== Globals ====
+int verbose = 0;
+int num_threads = 4;
+
+typedef struct {
+    char *rel_path;
+    long long size;
+    long long mtime;
+    char checksum[HASH_SIZE];
+    int ok;
+} CopyJob;
+
+CopyJob *jobs = NULL;
+int job_count = 0, job_capacity = 0;
+int next_job = 0;
+
+char source_root[MAX_PATH];
+char snapshot_dir[MAX_PATH];
+char prev_snapshot_dir[MAX_PATH];
+
+// Counters (Protected by count_mutex once workers start)
+int num_linked = 0, num_copied = 0, num_stale = 0, num_errors = 0;
+long long bytes_copied = 0;
+
+pthread_mutex_t job_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t count_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void print_usage(const char *prog_name) {
+    fprintf(stderr, "Usage: %s -p <source> -b <backup_root> [-d db_name] [-t threads] [-v]\n", prog_name);
+    fprintf(stderr, "  -p <source>  Path that was scanned by file_tracker\n");
+    fprintf(stderr, "  -b <root>    Directory holding the dated snapshots\n");
+    fprintf(stderr, "  -d <name>    Database name (default: basename of the source, without .db)\n");
+    fprintf(stderr, "  -t <num>     Copies in flight (default 4)\n");
+    fprintf(stderr, "  -v           Verbose output\n");
+    fprintf(stderr, "\nUnchanged files are hardlinked from the previous snapshot; NEW and CHANGED\n");
+    fprintf(stderr, "files are copied. Each snapshot gets a <snapshot>.manifest database of\n");
+    fprintf(stderr, "paths, sizes, mtimes and checksums.\n");
+}
+
+// ==== Utility: Create directory with parents ====
+int mkdir_p(const char *path) {
+    char tmp[MAX_PATH];
+    char *p = NULL;
+    size_t len;
+
+    snprintf(tmp, sizeof(tmp), "%s", path);
+    len = strlen(tmp);
+    if (tmp[len - 1] == '/') tmp[len - 1] = 0;
+
+    for (p = tmp + 1; *p; p++) {
+        if (*p == '/') {
+            *p = 0;
+            if (mkdir(tmp, 0755) != 0 && errno != EEXIST) {
+                return -1;
+            }
+            *p = '/';
+        }
+    }
+    if (mkdir(tmp, 0755) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    return 0;
+}
+
+// Create the parent directory of a snapshot path. Rows arrive in path order,
+// so remembering the last directory avoids a mkdir per file.
+int ensure_parent(const char *path) {
+    static __thread char last_dir[MAX_PATH] = "";
+    char dir[MAX_PATH];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (!slash) return 0;
+    *slash = '\0';
+    if (strcmp(dir, last_dir) == 0) return 0;
+    if (mkdir_p(dir) != 0) return -1;
+    snprintf(last_dir, sizeof(last_dir), "%s", dir);
+    return 0;
+}
+
+// ==== Copying ====
+// Copy src to dst, preferring a reflink, then an in-kernel copy, then plain
+// read/write. The source's mode and mtime are carried over. Returns 0, -1 on
+// error, or 1 if the source was modified while it was copied, in which case
+// the copy (possibly a mix of old and new contents) is removed.
+int copy_file(const char *src, const char *dst) {
+#ifdef __APPLE__
+    if (clonefile(src, dst, CLONE_NOFOLLOW) == 0) return 0;
+#endif
+    int in = open(src, O_RDONLY);
+    if (in < 0) return -1;
+
+    struct stat st;
+    if (fstat(in, &st) != 0) {
+        close(in);
+        return -1;
+    }
+
+    int out = open(dst, O_WRONLY | O_CREAT | O_EXCL, st.st_mode & 07777);
+    if (out < 0) {
+        close(in);
+        return -1;
+    }
+
+    int rc = -1;
+#ifdef __linux__
+    if (ioctl(out, FICLONE, in) == 0) {
+        rc = 0;
+    } else {
+        off_t remaining = st.st_size;
+        while (remaining > 0) {
+            ssize_t n = copy_file_range(in, NULL, out, NULL, remaining, 0);
+            if (n <= 0) break;
+            remaining -= n;
+        }
+        if (remaining == 0) rc = 0;
+        else if (lseek(in, 0, SEEK_SET) != 0 || ftruncate(out, 0) != 0 || lseek(out, 0, SEEK_SET) != 0) {
+            rc = -2;
+        }
+    }
+#endif
+    if (rc == -1) {
+        const int bufSize = 1 << 20;
+        char *buffer = malloc(bufSize);
+        ssize_t n = 0;
+        rc = 0;
+        while (buffer && (n = read(in, buffer, bufSize)) > 0) {
+            char *p = buffer;
+            while (n > 0) {
+                ssize_t w = write(out, p, n);
+                if (w <= 0) {
+                    rc = -1;
+                    break;
+                }
+                p += w;
+                n -= w;
+            }
+            if (rc != 0) break;
+        }
+        if (!buffer || n < 0) rc = -1;
+        free(buffer);
+    }
+
+    if (rc == 0) {
+        struct stat after;
+        if (fstat(in, &after) != 0 || after.st_size != st.st_size ||
+            after.st_mtim.tv_sec != st.st_mtim.tv_sec || after.st_mtim.tv_nsec != st.st_mtim.tv_nsec) {
+            rc = 1;
+        }
+    }
+    if (rc == 0) {
+        struct timespec times[2] = { st.st_atim, st.st_mtim };
+        futimens(out, times);
+    }
+    if (close(out) != 0 && rc == 0) rc = -1;
+    close(in);
+    if (rc != 0) unlink(dst);
+    return rc == 0 || rc == 1 ? rc : -1;
+}
+
+void *copy_worker(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&job_mutex);
+        int i = next_job++;
+        pthread_mutex_unlock(&job_mutex);
+        if (i >= job_count) break;
+
+        CopyJob *job = &jobs[i];
+        char src[MAX_PATH], dst[MAX_PATH];
+        // main only queues paths that fit, so this is just a safety net
+        if (snprintf(src, sizeof(src), "%s/%s", source_root, job->rel_path) >= (int)sizeof(src) ||
+            snprintf(dst, sizeof(dst), "%s/%s", snapshot_dir, job->rel_path) >= (int)sizeof(dst)) {
+            fprintf(stderr, "Error: Path too long, not copied: %s\n", job->rel_path);
+            pthread_mutex_lock(&count_mutex);
+            num_errors++;
+            pthread_mutex_unlock(&count_mutex);
+            continue;
+        }
+
+        int copied = ensure_parent(dst) == 0 ? 1 : -1;
+        for (int attempt = 0; copied == 1 && attempt < COPY_ATTEMPTS; attempt++) copied = copy_file(src, dst);
+        if (copied != 0) {
+            if (copied == 1) fprintf(stderr, "Error: %s kept changing while it was copied\n", src);
+            else fprintf(stderr, "Error: Failed to copy %s: %s\n", src, strerror(errno));
+            pthread_mutex_lock(&count_mutex);
+            num_errors++;
+            pthread_mutex_unlock(&count_mutex);
+            continue;
+        }
+        job->ok = 1;
+
+        // The tracker's checksum only describes the file if it has not been
+        // modified since the last scan
+        struct stat st;
+        int have_stat = stat(dst, &st) == 0;
+        int stale = (!have_stat || st.st_size != job->size || st.st_mtime != job->mtime);
+        if (stale) job->checksum[0] = '\0';
+
+        if (verbose) printf("[COPIED%s] %s\n", stale ? ", STALE" : "", job->rel_path);
+
+        pthread_mutex_lock(&count_mutex);
+        num_copied++;
+        if (stale) num_stale++;
+        if (have_stat) bytes_copied += st.st_size;
+        pthread_mutex_unlock(&count_mutex);
+    }
+    return NULL;
+}
+
+void add_job(const char *rel_path, long long size, long long mtime, const char *checksum) {
+    if (job_count >= job_capacity) {
+        job_capacity = job_capacity == 0 ? 256 : job_capacity * 2;
+        jobs = realloc(jobs, job_capacity * sizeof(CopyJob));
+    }
+    CopyJob *job = &jobs[job_count++];
+    job->rel_path = strdup(rel_path);
+    job->size = size;
+    job->mtime = mtime;
+    snprintf(job->checksum, sizeof(job->checksum), "%s", checksum ? checksum : "");
+    job->ok = 0;
+}
+
+// ==== Database ====
+// Databases written with "file_tracker -S" keep rows in <name>.shard<k>.db
+// next to <name>.db. Attach them and expose every row as tracked_files.
+// file_tracker stamps every shard with the same run_id and commits shard 0
+// last, so a shard whose run_id differs from shard 0's was left by a run that
+// did not finish; it is reported and -2 returned.
+void read_run_id(sqlite3 *db, const char *schema, char *run_id, size_t size) {
+    char sql[128];
+    sqlite3_stmt *stmt;
+    run_id[0] = '\0';
+    snprintf(sql, sizeof(sql), "SELECT value FROM %s.metadata WHERE key = 'run_id'", schema);
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) return;
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0)) {
+        snprintf(run_id, size, "%s", (const char *)sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+}
+
+int attach_shards(sqlite3 *db, const char *db_path) {
+    char sql[2048];
+    int len = snprintf(sql, sizeof(sql),
+                       "CREATE TEMP VIEW tracked_files AS SELECT full_path, size, last_modified, checksum FROM main.files");
+    size_t base_len = strlen(db_path) - 3;
+    char main_run[64];
+    read_run_id(db, "main", main_run, sizeof(main_run));
+    for (int k = 1; k < MAX_SHARDS; k++) {
+        char shard_path[MAX_PATH], attach[64], schema[16], shard_run[64];
+        snprintf(shard_path, sizeof(shard_path), "%.*s.shard%d.db", (int)base_len, db_path, k);
+        if (access(shard_path, F_OK) != 0) break;
+
+        sqlite3_stmt *stmt;
+        snprintf(attach, sizeof(attach), "ATTACH DATABASE ? AS shard%d", k);
+        if (sqlite3_prepare_v2(db, attach, -1, &stmt, NULL) != SQLITE_OK) return -1;
+        sqlite3_bind_text(stmt, 1, shard_path, -1, SQLITE_STATIC);
+        int rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) return -1;
+
+        snprintf(schema, sizeof(schema), "shard%d", k);
+        read_run_id(db, schema, shard_run, sizeof(shard_run));
+        if (main_run[0] && strcmp(main_run, shard_run) != 0) {
+            fprintf(stderr, "Error: %s was left by an unfinished file_tracker run; run file_tracker -u again\n", shard_path);
+            return -2;
+        }
+
+        len += snprintf(sql + len, sizeof(sql) - len,
+                        " UNION ALL SELECT full_path, size, last_modified, checksum FROM shard%d.files", k);
+    }
+    return sqlite3_exec(db, sql, 0, 0, 0) == SQLITE_OK ? 0 : -1;
+}
+
+// ==== Manifests ====
+// The newest <stamp>_Snapshot.manifest in the backup root; stamps sort by time.
+int find_previous_snapshot(const char *backup_root, char *manifest_path) {
+    DIR *dir = opendir(backup_root);
+    if (!dir) return 0;
+
+    const char *suffix = "_Snapshot.manifest";
+    size_t suffix_len = strlen(suffix);
+    char best[256] = "";
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len <= suffix_len || strcmp(entry->d_name + len - suffix_len, suffix) != 0) continue;
+        if (len < sizeof(best) && strcmp(entry->d_name, best) > 0) {
+            snprintf(best, sizeof(best), "%s", entry->d_name);
+        }
+    }
+    closedir(dir);
+
+    if (!best[0]) return 0;
+    snprintf(manifest_path, MAX_PATH, "%s/%s", backup_root, best);
+    // The snapshot directory shares the manifest's name minus ".manifest"
+    snprintf(prev_snapshot_dir, sizeof(prev_snapshot_dir), "%s/%.*s", backup_root,
+             (int)(strlen(best) - strlen(".manifest")), best);
+    return 1;
+}
+
+void manifest_add(sqlite3_stmt *stmt, const char *rel_path, long long size, long long mtime, const char *checksum) {
+    sqlite3_bind_text(stmt, 1, rel_path, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, size);
+    sqlite3_bind_int64(stmt, 3, mtime);
+    if (checksum && checksum[0]) sqlite3_bind_text(stmt, 4, checksum, -1, SQLITE_STATIC);
+    else sqlite3_bind_null(stmt, 4);
+    sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+}
+
+int main(int argc, char *argv[]) {
+    char *path_arg = NULL;
+    char *backup_root = NULL;
+    char *db_name = NULL;
+
+    setlocale(LC_NUMERIC, "");
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) path_arg = argv[++i];
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) backup_root = argv[++i];
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) db_name = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) num_threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-v") == 0) verbose = 1;
+        else if (strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!path_arg || !backup_root) {
+        fprintf(stderr, "Error: -p and -b options are required\n\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (num_threads < 1) num_threads = 1;
+
+    snprintf(source_root, sizeof(source_root), "%s", path_arg);
+    size_t root_len = strlen(source_root);
+    while (root_len > 1 && source_root[root_len - 1] == '/') source_root[--root_len] = '\0';
+
+    const char *home = getenv("HOME");
+    if (!home) {
+        fprintf(stderr, "Error: HOME environment variable not set\n");
+        return 1;
+    }
+
+    char db_path[MAX_PATH];
+    if (db_name) {
+        snprintf(db_path, sizeof(db_path), "%s/db/FileTracker/%s.db", home, db_name);
+    } else {
+        char *path_copy = strdup(source_root);
+        snprintf(db_path, sizeof(db_path), "%s/db/FileTracker/%s.db", home, basename(path_copy));
+        free(path_copy);
+    }
+
+    sqlite3 *db;
+    if (sqlite3_open_v2(db_path, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Error: Failed to open database %s: %s\n", db_path, sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    sqlite3_busy_timeout(db, 30000);
+    int attached = attach_shards(db, db_path);
+    if (attached != 0) {
+        if (attached == -1) fprintf(stderr, "Error: Failed to attach shards of %s: %s\n", db_path, sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // Previous snapshot, if any, supplies the files to hardlink
+    char prev_manifest[MAX_PATH];
+    sqlite3 *prev = NULL;
+    sqlite3_stmt *prev_stmt = NULL;
+    if (find_previous_snapshot(backup_root, prev_manifest)) {
+        if (sqlite3_open_v2(prev_manifest, &prev, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK ||
+            sqlite3_prepare_v2(prev, "SELECT size, last_modified, checksum FROM snapshot_files WHERE path = ?", -1, &prev_stmt, NULL) != SQLITE_OK) {
+            fprintf(stderr, "Warning: Ignoring unreadable manifest %s\n", prev_manifest);
+            sqlite3_close(prev);
+            prev = NULL;
+        }
+    }
+
+    time_t now = time(NULL);
+    char stamp[64];
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d_%H%M%S", localtime(&now));
+    snprintf(snapshot_dir, sizeof(snapshot_dir), "%s/%s_Snapshot", backup_root, stamp);
+
+    if (mkdir_p(backup_root) != 0 || mkdir(snapshot_dir, 0755) != 0) {
+        fprintf(stderr, "Error: Could not create snapshot directory %s: %s\n", snapshot_dir, strerror(errno));
+        return 1;
+    }
+
+    // Manifest is written next to the snapshot so it is not part of the tree.
+    // It only gets its final name once the snapshot is complete, so
+    // find_previous_snapshot never builds on an interrupted one.
+    char manifest_path[MAX_PATH], manifest_tmp[MAX_PATH];
+    if (snprintf(manifest_path, sizeof(manifest_path), "%s.manifest", snapshot_dir) >= (int)sizeof(manifest_path) ||
+        snprintf(manifest_tmp, sizeof(manifest_tmp), "%s.tmp", manifest_path) >= (int)sizeof(manifest_tmp)) {
+        fprintf(stderr, "Error: Manifest path too long: %s.manifest.tmp\n", snapshot_dir);
+        return 1;
+    }
+    sqlite3 *mdb;
+    unlink(manifest_tmp);
+    if (sqlite3_open(manifest_tmp, &mdb) != SQLITE_OK) {
+        fprintf(stderr, "Error: Failed to create manifest %s: %s\n", manifest_tmp, sqlite3_errmsg(mdb));
+        return 1;
+    }
+    sqlite3_exec(mdb, "CREATE TABLE IF NOT EXISTS snapshot_files (path TEXT PRIMARY KEY, size INTEGER, last_modified INTEGER, checksum TEXT);", 0, 0, 0);
+    sqlite3_exec(mdb, "CREATE TABLE IF NOT EXISTS snapshot (key TEXT PRIMARY KEY, value TEXT);", 0, 0, 0);
+    sqlite3_exec(mdb, "BEGIN TRANSACTION;", 0, 0, 0);
+
+    sqlite3_stmt *mstmt;
+    sqlite3_prepare_v2(mdb, "INSERT OR REPLACE INTO snapshot_files (path, size, last_modified, checksum) VALUES (?, ?, ?, ?)", -1, &mstmt, NULL);
+
+    // Rows under the root: full_path in ("<root>/", "<root>0"), '0' being '/' + 1
+    char lo[MAX_PATH], hi[MAX_PATH];
+    snprintf(lo, sizeof(lo), "%s/", source_root);
+    snprintf(hi, sizeof(hi), "%s0", source_root);
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT full_path, size, last_modified, checksum FROM tracked_files WHERE full_path > ? AND full_path < ? ORDER BY full_path", -1, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Error: Failed to query %s: %s\n", db_path, sqlite3_errmsg(db));
+        return 1;
+    }
+    sqlite3_bind_text(stmt, 1, lo, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, hi, -1, SQLITE_STATIC);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *full_path = (const char *)sqlite3_column_text(stmt, 0);
+        long long size = sqlite3_column_int64(stmt, 1);
+        long long mtime = sqlite3_column_int64(stmt, 2);
+        const char *checksum = (const char *)sqlite3_column_text(stmt, 3);
+        const char *rel_path = full_path + root_len + 1;
+
+        char src[MAX_PATH], dst[MAX_PATH];
+        if (snprintf(src, sizeof(src), "%s/%s", source_root, rel_path) >= (int)sizeof(src) ||
+            snprintf(dst, sizeof(dst), "%s/%s", snapshot_dir, rel_path) >= (int)sizeof(dst)) {
+            fprintf(stderr, "Error: Path too long, not copied: %s\n", full_path);
+            num_errors++;
+            continue;
+        }
+
+        int unchanged = 0;
+        if (prev_stmt) {
+            sqlite3_bind_text(prev_stmt, 1, rel_path, -1, SQLITE_STATIC);
+            if (sqlite3_step(prev_stmt) == SQLITE_ROW) {
+                const char *prev_checksum = (const char *)sqlite3_column_text(prev_stmt, 2);
+                unchanged = sqlite3_column_int64(prev_stmt, 0) == size &&
+                            sqlite3_column_int64(prev_stmt, 1) == mtime &&
+                            prev_checksum && checksum && strcmp(prev_checksum, checksum) == 0;
+            }
+            sqlite3_reset(prev_stmt);
+        }
+        // The previous copy holds the row's version, which the source may no
+        // longer be if it changed since the last file_tracker run; copy it then
+        struct stat src_st;
+        if (unchanged && (stat(src, &src_st) != 0 || src_st.st_size != size || src_st.st_mtime != mtime)) {
+            unchanged = 0;
+        }
+
+        if (unchanged) {
+            char prev_path[MAX_PATH];
+            int prev_len = snprintf(prev_path, sizeof(prev_path), "%s/%s", prev_snapshot_dir, rel_path);
+            if (prev_len < (int)sizeof(prev_path) && ensure_parent(dst) == 0 && link(prev_path, dst) == 0) {
+                if (verbose) printf("[LINKED] %s\n", rel_path);
+                manifest_add(mstmt, rel_path, size, mtime, checksum);
+                num_linked++;
+                continue;
+            }
+            // Previous copy gone or the link count is exhausted; copy instead
+        }
+        add_job(rel_path, size, mtime, checksum);
+    }
+    sqlite3_finalize(stmt);
+    if (prev_stmt) sqlite3_finalize(prev_stmt);
+    if (prev) sqlite3_close(prev);
+    sqlite3_close(db);
+
+    // Copy NEW and CHANGED files with several copies in flight
+    int thread_count = num_threads < job_count ? num_threads : job_count;
+    pthread_t *threads = malloc((thread_count > 0 ? thread_count : 1) * sizeof(pthread_t));
+    int started = 0;
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&threads[started], NULL, copy_worker, NULL) == 0) started++;
+    }
+    if (started == 0) copy_worker(NULL);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    for (int i = 0; i < job_count; i++) {
+        if (jobs[i].ok) manifest_add(mstmt, jobs[i].rel_path, jobs[i].size, jobs[i].mtime, jobs[i].checksum);
+        free(jobs[i].rel_path);
+    }
+    free(jobs);
+    sqlite3_finalize(mstmt);
+
+    sqlite3_stmt *info;
+    sqlite3_prepare_v2(mdb, "INSERT OR REPLACE INTO snapshot (key, value) VALUES (?, ?)", -1, &info, NULL);
+    const char *keys[] = { "source", "database", "created" };
+    char created[32];
+    strftime(created, sizeof(created), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    const char *values[] = { source_root, db_path, created };
+    for (int i = 0; i < 3; i++) {
+        sqlite3_bind_text(info, 1, keys[i], -1, SQLITE_STATIC);
+        sqlite3_bind_text(info, 2, values[i], -1, SQLITE_STATIC);
+        sqlite3_step(info);
+        sqlite3_reset(info);
+    }
+    sqlite3_finalize(info);
+    if (sqlite3_exec(mdb, "COMMIT;", 0, 0, 0) != SQLITE_OK) {
+        fprintf(stderr, "Error: Failed to write manifest %s: %s\n", manifest_tmp, sqlite3_errmsg(mdb));
+        sqlite3_close(mdb);
+        num_errors++;
+    } else {
+        sqlite3_close(mdb);
+        if (rename(manifest_tmp, manifest_path) != 0) {
+            fprintf(stderr, "Error: Failed to rename %s: %s\n", manifest_tmp, strerror(errno));
+            num_errors++;
+        }
+    }
+
+    printf("Snapshot       : %s\n", snapshot_dir);
+    printf("Linked         : %'d\n", num_linked);
+    printf("Copied         : %'d (%'lld bytes)\n", num_copied, bytes_copied);
+    printf("Stale          : %'d\n", num_stale);
+    printf("Errors         : %'d\n", num_errors);
+
+    return num_errors > 0 ? 1 : 0;
+}
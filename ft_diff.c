@@ -0,0 +1,264 @@
+#include <locale.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_PATH 4096
+#define MAX_SHARDS 8
+
+// ==== Globals ====
+int ignore_mtime = 0;
+int quiet = 0;
+
+long long num_same = 0, num_only_a = 0, num_only_b = 0, num_differ = 0, num_format = 0;
+
+// One database (all of its shards) streamed in full_path order. Each shard
+// is already ordered by its UNIQUE index, so merging them keeps memory flat.
+typedef struct {
+    const char *db_path;
+    const char *prefix;
+    size_t prefix_len;
+    sqlite3 *dbs[MAX_SHARDS];
+    sqlite3_stmt *stmts[MAX_SHARDS];
+    int has_row[MAX_SHARDS];
+    int count;
+    int current;        // shard holding the smallest current row, -1 at end
+} Side;
+
+void print_usage(const char *prog_name) {
+    fprintf(stderr, "Usage: %s [-A prefix] [-B prefix] [-m] [-q] a.db b.db\n", prog_name);
+    fprintf(stderr, "  -A <prefix>  Only compare A's paths under prefix, with prefix removed\n");
+    fprintf(stderr, "  -B <prefix>  Only compare B's paths under prefix, with prefix removed\n");
+    fprintf(stderr, "  -m           Ignore last-modified differences\n");
+    fprintf(stderr, "  -q           Only print the summary\n");
+    fprintf(stderr, "\nExample (primary /data vs mirror /mnt/mirror/data):\n");
+    fprintf(stderr, "  %s -A /data -B /mnt/mirror/data primary/data.db mirror/data.db\n", prog_name);
+}
+
+const char *row_path(Side *side) {
+    return (const char *)sqlite3_column_text(side->stmts[side->current], 0) + side->prefix_len;
+}
+
+sqlite3_stmt *row(Side *side) {
+    return side->stmts[side->current];
+}
+
+// Pick the shard whose current row sorts first
+void select_current(Side *side) {
+    side->current = -1;
+    for (int k = 0; k < side->count; k++) {
+        if (!side->has_row[k]) continue;
+        if (side->current < 0 ||
+            strcmp((const char *)sqlite3_column_text(side->stmts[k], 0),
+                   (const char *)sqlite3_column_text(side->stmts[side->current], 0)) < 0) {
+            side->current = k;
+        }
+    }
+}
+
+void advance(Side *side) {
+    int k = side->current;
+    side->has_row[k] = (sqlite3_step(side->stmts[k]) == SQLITE_ROW);
+    select_current(side);
+}
+
+int open_stream(sqlite3 *db, const char *prefix, sqlite3_stmt **stmt) {
+    if (prefix[0]) {
+        // full_path in ("<prefix>/", "<prefix>0"), '0' being '/' + 1
+        if (sqlite3_prepare_v2(db, "SELECT full_path, size, last_modified, checksum FROM files "
+                                   "WHERE full_path > ? || '/' AND full_path < ? || '0' ORDER BY full_path",
+                               -1, stmt, NULL) != SQLITE_OK) return -1;
+        sqlite3_bind_text(*stmt, 1, prefix, -1, SQLITE_STATIC);
+        sqlite3_bind_text(*stmt, 2, prefix, -1, SQLITE_STATIC);
+        return 0;
+    }
+    return sqlite3_prepare_v2(db, "SELECT full_path, size, last_modified, checksum FROM files ORDER BY full_path",
+                              -1, stmt, NULL) == SQLITE_OK ? 0 : -1;
+}
+
+// The run_id file_tracker -S stamps on every shard, empty if there is none
+void read_run_id(sqlite3 *db, char *run_id, size_t size) {
+    sqlite3_stmt *stmt;
+    run_id[0] = '\0';
+    if (sqlite3_prepare_v2(db, "SELECT value FROM metadata WHERE key = 'run_id'", -1, &stmt, NULL) != SQLITE_OK) return;
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0)) {
+        snprintf(run_id, size, "%s", (const char *)sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+}
+
+// Open <name>.db and any <name>.shard<k>.db written by "file_tracker -S".
+// file_tracker commits shard 0 last, so a shard whose run_id differs from
+// shard 0's was left by a run that did not finish and is refused.
+int open_side(Side *side) {
+    size_t len = strlen(side->db_path);
+    char main_run[64] = "";
+    side->count = 0;
+    for (int k = 0; k < MAX_SHARDS; k++) {
+        char path[MAX_PATH];
+        if (k == 0) {
+            snprintf(path, sizeof(path), "%s", side->db_path);
+        } else {
+            if (len <= 3 || strcmp(side->db_path + len - 3, ".db") != 0) break;
+            snprintf(path, sizeof(path), "%.*s.shard%d.db", (int)(len - 3), side->db_path, k);
+            if (access(path, F_OK) != 0) break;
+        }
+
+        sqlite3 *db;
+        if (sqlite3_open_v2(path, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+            fprintf(stderr, "Error: Failed to open database %s: %s\n", path, sqlite3_errmsg(db));
+            sqlite3_close(db);
+            return -1;
+        }
+        sqlite3_busy_timeout(db, 30000);
+        side->dbs[k] = db;
+        side->count++;
+
+        char run_id[64];
+        read_run_id(db, run_id, sizeof(run_id));
+        if (k == 0) {
+            snprintf(main_run, sizeof(main_run), "%s", run_id);
+        } else if (main_run[0] && strcmp(main_run, run_id) != 0) {
+            fprintf(stderr, "Error: %s was left by an unfinished file_tracker run; run file_tracker -u again\n", path);
+            return -1;
+        }
+
+        if (open_stream(db, side->prefix, &side->stmts[k]) != 0) {
+            fprintf(stderr, "Error: Failed to query %s: %s\n", path, sqlite3_errmsg(db));
+            return -1;
+        }
+        side->has_row[k] = (sqlite3_step(side->stmts[k]) == SQLITE_ROW);
+    }
+    select_current(side);
+    return 0;
+}
+
+void close_side(Side *side) {
+    for (int k = 0; k < side->count; k++) {
+        if (side->stmts[k]) sqlite3_finalize(side->stmts[k]);
+        sqlite3_close(side->dbs[k]);
+    }
+}
+
+// Chunk size of a tree hash checksum written by "file_tracker -M", 0 for a
+// plain SHA-256
+int checksum_chunk_mib(const char *checksum) {
+    if (!checksum || checksum[0] != 'm') return 0;
+    char *end;
+    long mib = strtol(checksum + 1, &end, 10);
+    return (*end == ':' && mib > 0) ? (int)mib : 0;
+}
+
+// Compare two rows for the same relative path. A plain SHA-256 and a tree
+// hash, or tree hashes of different chunk sizes, differ for identical
+// contents, so such rows are compared by size and mtime only.
+void compare_rows(Side *a, Side *b) {
+    sqlite3_stmt *ra = row(a), *rb = row(b);
+    const char *ca = (const char *)sqlite3_column_text(ra, 3);
+    const char *cb = (const char *)sqlite3_column_text(rb, 3);
+    int size_diff = sqlite3_column_int64(ra, 1) != sqlite3_column_int64(rb, 1);
+    int mtime_diff = !ignore_mtime && sqlite3_column_int64(ra, 2) != sqlite3_column_int64(rb, 2);
+    int hash_diff = 0;
+    if (ca && cb && checksum_chunk_mib(ca) != checksum_chunk_mib(cb)) num_format++;
+    else hash_diff = (ca && cb) ? strcmp(ca, cb) != 0 : (ca != cb);
+
+    if (!size_diff && !mtime_diff && !hash_diff) {
+        num_same++;
+        return;
+    }
+    num_differ++;
+    if (!quiet) {
+        char reason[32] = "";
+        if (hash_diff) strcat(reason, "checksum");
+        if (size_diff) strcat(reason, reason[0] ? ",size" : "size");
+        if (mtime_diff) strcat(reason, reason[0] ? ",mtime" : "mtime");
+        printf("DIFFER  %s (%s)\n", row_path(a), reason);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Side a, b;
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    a.prefix = b.prefix = "";
+
+    setlocale(LC_NUMERIC, "");
+
+    int i;
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-A") == 0 && i + 1 < argc) a.prefix = argv[++i];
+        else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc) b.prefix = argv[++i];
+        else if (strcmp(argv[i], "-m") == 0) ignore_mtime = 1;
+        else if (strcmp(argv[i], "-q") == 0) quiet = 1;
+        else if (strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - i != 2) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    a.db_path = argv[i];
+    b.db_path = argv[i + 1];
+
+    // A prefix is matched as a directory, so drop any trailing slash
+    char prefix_a[MAX_PATH], prefix_b[MAX_PATH];
+    snprintf(prefix_a, sizeof(prefix_a), "%s", a.prefix);
+    snprintf(prefix_b, sizeof(prefix_b), "%s", b.prefix);
+    for (size_t n = strlen(prefix_a); n > 0 && prefix_a[n - 1] == '/'; n--) prefix_a[n - 1] = '\0';
+    for (size_t n = strlen(prefix_b); n > 0 && prefix_b[n - 1] == '/'; n--) prefix_b[n - 1] = '\0';
+    a.prefix = prefix_a;
+    b.prefix = prefix_b;
+    a.prefix_len = strlen(prefix_a);
+    b.prefix_len = strlen(prefix_b);
+
+    if (open_side(&a) != 0 || open_side(&b) != 0) {
+        close_side(&a);
+        close_side(&b);
+        return 2;
+    }
+
+    // Merge-join: both streams are ordered by path with the same prefix
+    // removed, so each row is visited exactly once
+    while (a.current >= 0 || b.current >= 0) {
+        int cmp;
+        if (a.current < 0) cmp = 1;
+        else if (b.current < 0) cmp = -1;
+        else cmp = strcmp(row_path(&a), row_path(&b));
+
+        if (cmp < 0) {
+            num_only_a++;
+            if (!quiet) printf("ONLY_A  %s\n", row_path(&a));
+            advance(&a);
+        } else if (cmp > 0) {
+            num_only_b++;
+            if (!quiet) printf("ONLY_B  %s\n", row_path(&b));
+            advance(&b);
+        } else {
+            compare_rows(&a, &b);
+            advance(&a);
+            advance(&b);
+        }
+    }
+
+    close_side(&a);
+    close_side(&b);
+
+    printf("\n================ DIFF SUMMARY ================\n");
+    printf("A              : %s%s%s\n", a.db_path, a.prefix_len ? " " : "", a.prefix);
+    printf("B              : %s%s%s\n", b.db_path, b.prefix_len ? " " : "", b.prefix);
+    printf("Same           : %'lld\n", num_same);
+    printf("Only in A      : %'lld\n", num_only_a);
+    printf("Only in B      : %'lld\n", num_only_b);
+    printf("Different      : %'lld\n", num_differ);
+    if (num_format) printf("Hash Format    : %'lld differ (compared by size and mtime only)\n", num_format);
+    printf("==============================================\n");
+
+    return (num_only_a || num_only_b || num_differ) ? 1 : 0;
+}
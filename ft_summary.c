@@ -1,20 +1,91 @@
+#define _GNU_SOURCE
 #include <sqlite3.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <locale.h>
+#include <math.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
 
 #define MAX_PATH 4096
+#define MAX_DB_NAME 256
+#define MAX_WINDOW 64
+
+// ==== Multi-database (--all) state ====
+typedef struct {
+    char name[MAX_DB_NAME];
+    char path[MAX_PATH];
+    int ok;                     // 1 if meta rows were read
+    char error[128];
+    int runs_read;              // rows read (<= window)
+    char last_date[20];
+    char machine[16];
+    char update_mode[8];
+    int unchanged, changed, new_files, missing, moved, errors;
+    long long oldest_files;     // tracked files at the oldest run in the window
+    long long churn_total;      // changed + new + missing summed over the window
+    time_t last_time;
+} DbSummary;
+
+DbSummary *summaries = NULL;
+int summary_count = 0;
+int next_summary = 0;
+int window_runs = 7;
+pthread_mutex_t summary_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 void print_usage(const char *prog_name) {
     fprintf(stderr, "Usage: %s -d <database_name> [-a]\n", prog_name);
+    fprintf(stderr, "       %s -d <database_name> --perf [-a] [-n runs] [-T percent] [--csv | --json]\n", prog_name);
+    fprintf(stderr, "       %s --all [-n runs] [-S hours] [-t threads]\n", prog_name);
     fprintf(stderr, "  -d <name>   Database name (without .db extension)\n");
     fprintf(stderr, "  -a          Show all runs (default: last run only)\n");
+    fprintf(stderr, "  --all       Summarize every database in one table\n");
+    fprintf(stderr, "  --perf      Throughput, growth and churn per run, flagging runs off the trend\n");
+    fprintf(stderr, "  -n <runs>   Runs used for trends with --all and --perf (default 7, max %d)\n", MAX_WINDOW);
+    fprintf(stderr, "  -T <pct>    Flag --perf runs deviating more than this from the trend (default 25)\n");
+    fprintf(stderr, "  --csv       --perf output as CSV\n");
+    fprintf(stderr, "  --json      --perf output as JSON\n");
+    fprintf(stderr, "  -S <hours>  Flag databases whose last run is older than this (default 36)\n");
+    fprintf(stderr, "  -t <num>    Databases read in parallel with --all (default 8)\n");
     fprintf(stderr, "\nDatabases are located in $HOME/db/FileTracker/\n");
     fprintf(stderr, "\nExample:\n");
     fprintf(stderr, "  %s -d MyFiles        # Show last run for MyFiles.db\n", prog_name);
     fprintf(stderr, "  %s -d MyFiles -a     # Show all runs for MyFiles.db\n", prog_name);
+    fprintf(stderr, "  %s -d MyFiles --perf # Speed and growth of the last 7 runs\n", prog_name);
+    fprintf(stderr, "  %s --all             # Status of every database\n", prog_name);
+}
+
+// Prepare a meta query, falling back for databases created before the
+// update_mode column existed. file_tracker adds the column on its next run;
+// ft_summary never writes to the database.
+int prepare_meta_query(sqlite3 *db, const char *suffix, sqlite3_stmt **stmt) {
+    // Newest schema first; older databases lack the run timings, then
+    // num_moved and then update_mode
+    const char *optional[] = {
+        "update_mode, num_moved, scan_seconds, file_count, total_bytes, bytes_hashed",
+        "update_mode, num_moved, NULL, NULL, NULL, NULL",
+        "update_mode, NULL, NULL, NULL, NULL, NULL",
+        "NULL, NULL, NULL, NULL, NULL, NULL"
+    };
+    int rc = SQLITE_ERROR;
+    for (int i = 0; i < 4 && rc != SQLITE_OK; i++) {
+        char sql[512];
+        snprintf(sql, sizeof(sql),
+                 "SELECT id, last_checksum_verify_date, last_date_verify, verify_machine, "
+                 "num_unchanged, num_changed, num_new, num_missing, num_errors, %s "
+                 "FROM meta %s", optional[i], suffix);
+        rc = sqlite3_prepare_v2(db, sql, -1, stmt, NULL);
+    }
+    return rc;
+}
+
+int open_readonly(const char *db_path, sqlite3 **db) {
+    int rc = sqlite3_open_v2(db_path, db, SQLITE_OPEN_READONLY, NULL);
+    if (rc == SQLITE_OK) sqlite3_busy_timeout(*db, 5000);
+    return rc;
 }
 
 void print_separator(int width) {
@@ -35,6 +106,7 @@ void print_single_run(sqlite3_stmt *stmt) {
     int missing = sqlite3_column_int(stmt, 7);
     int errors = sqlite3_column_int(stmt, 8);
     const char *update_mode = (const char *)sqlite3_column_text(stmt, 9);
+    int moved = sqlite3_column_int(stmt, 10);
 
     printf("\n==================== RUN #%d ====================\n", id);
 
@@ -50,6 +122,7 @@ void print_single_run(sqlite3_stmt *stmt) {
     printf("Changed:              %'d\n", changed);
     printf("New:                  %'d\n", new_files);
     printf("Missing:              %'d\n", missing);
+    printf("Moved:                %'d\n", moved);
     printf("Errors:               %'d\n", errors);
     printf("================================================\n");
 }
@@ -91,9 +164,532 @@ void print_table_row(sqlite3_stmt *stmt) {
            unchanged, changed, new_files, missing, errors);
 }
 
+// ==== Multi-database (--all) ====
+// Shards written by "file_tracker -S" (<name>.shard<k>.db) belong to <name>.db
+int is_shard_file(const char *name) {
+    const char *p = strstr(name, ".shard");
+    if (!p) return 0;
+    p += strlen(".shard");
+    if (*p < '0' || *p > '9') return 0;
+    while (*p >= '0' && *p <= '9') p++;
+    return strcmp(p, ".db") == 0;
+}
+
+time_t parse_run_date(const char *date) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    if (!date || !strptime(date, "%Y-%m-%d %H:%M:%S", &tm)) return 0;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+void summarize_database(DbSummary *s) {
+    sqlite3 *db;
+    if (open_readonly(s->path, &db) != SQLITE_OK) {
+        snprintf(s->error, sizeof(s->error), "%s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return;
+    }
+
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), "ORDER BY id DESC LIMIT %d", window_runs);
+    sqlite3_stmt *stmt;
+    if (prepare_meta_query(db, suffix, &stmt) != SQLITE_OK) {
+        snprintf(s->error, sizeof(s->error), "%s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return;
+    }
+
+    // Rows arrive newest first; the first row is the current state and the
+    // last row is the baseline for the trend.
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int unchanged = sqlite3_column_int(stmt, 4);
+        int changed = sqlite3_column_int(stmt, 5);
+        int new_files = sqlite3_column_int(stmt, 6);
+        int missing = sqlite3_column_int(stmt, 7);
+        int moved = sqlite3_column_int(stmt, 10);
+
+        if (s->runs_read == 0) {
+            const char *checksum_date = (const char *)sqlite3_column_text(stmt, 1);
+            const char *verify_date = (const char *)sqlite3_column_text(stmt, 2);
+            const char *machine = (const char *)sqlite3_column_text(stmt, 3);
+            const char *update_mode = (const char *)sqlite3_column_text(stmt, 9);
+            const char *date = (checksum_date && strlen(checksum_date) > 0) ? checksum_date : verify_date;
+
+            snprintf(s->last_date, sizeof(s->last_date), "%s", date ? date : "");
+            snprintf(s->machine, sizeof(s->machine), "%s", machine ? machine : "unknown");
+            snprintf(s->update_mode, sizeof(s->update_mode), "%s", update_mode ? update_mode : "UNK");
+            s->unchanged = unchanged;
+            s->changed = changed;
+            s->new_files = new_files;
+            s->moved = moved;
+            s->missing = missing;
+            s->errors = sqlite3_column_int(stmt, 8);
+            s->last_time = parse_run_date(date);
+        }
+        s->oldest_files = (long long)unchanged + changed + new_files + moved;
+        s->churn_total += (long long)changed + new_files + missing + moved;
+        s->runs_read++;
+    }
+    s->ok = 1;
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+}
+
+void *summary_worker(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&summary_mutex);
+        int i = next_summary++;
+        pthread_mutex_unlock(&summary_mutex);
+        if (i >= summary_count) break;
+        summarize_database(&summaries[i]);
+    }
+    return NULL;
+}
+
+int compare_summaries(const void *a, const void *b) {
+    return strcmp(((const DbSummary *)a)->name, ((const DbSummary *)b)->name);
+}
+
+int collect_databases(const char *db_dir) {
+    DIR *dir = opendir(db_dir);
+    if (!dir) {
+        fprintf(stderr, "Error: Cannot open directory: %s\n", db_dir);
+        return -1;
+    }
+
+    int capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len <= 3 || strcmp(entry->d_name + len - 3, ".db") != 0) continue;
+        if (len - 3 >= MAX_DB_NAME || is_shard_file(entry->d_name)) continue;
+
+        if (summary_count >= capacity) {
+            int grown_capacity = capacity == 0 ? 64 : capacity * 2;
+            DbSummary *grown = realloc(summaries, grown_capacity * sizeof(DbSummary));
+            if (!grown) {
+                fprintf(stderr, "Error: Out of memory listing %s\n", db_dir);
+                closedir(dir);
+                return -1;
+            }
+            summaries = grown;
+            capacity = grown_capacity;
+        }
+        DbSummary *s = &summaries[summary_count++];
+        memset(s, 0, sizeof(*s));
+        snprintf(s->name, sizeof(s->name), "%.*s", (int)(len - 3), entry->d_name);
+        snprintf(s->path, sizeof(s->path), "%s/%s", db_dir, entry->d_name);
+    }
+    closedir(dir);
+
+    qsort(summaries, summary_count, sizeof(DbSummary), compare_summaries);
+    return summary_count;
+}
+
+void print_all_header() {
+    printf("\n");
+    print_separator(150);
+    printf("%-24s | %-19s | %-15s | %-6s | %12s | %10s | %10s | %10s | %8s | %10s | %10s\n",
+           "Database", "Last Run", "Machine", "Update", "Files", "Changed", "New", "Missing", "Errors", "Trend", "Churn/Run");
+    print_separator(150);
+}
+
+void print_all_row(const DbSummary *s, int stale) {
+    if (!s->ok) {
+        printf("%-24.24s | ERROR: %s\n", s->name, s->error);
+        return;
+    }
+    if (s->runs_read == 0) {
+        printf("%-24.24s | no runs recorded\n", s->name);
+        return;
+    }
+
+    long long files = (long long)s->unchanged + s->changed + s->new_files + s->moved;
+    char trend[32];
+    if (s->runs_read > 1) {
+        snprintf(trend, sizeof(trend), "%+'lld", files - s->oldest_files);
+    } else {
+        snprintf(trend, sizeof(trend), "-");
+    }
+
+    printf("%-24.24s | %-19s | %-15s | %-6s | %'12lld | %'10d | %'10d | %'10d | %'8d | %10s | %'10lld%s\n",
+           s->name, s->last_date, s->machine, s->update_mode,
+           files, s->changed, s->new_files, s->missing, s->errors,
+           trend, s->churn_total / s->runs_read,
+           stale ? "  STALE" : "");
+}
+
+int summarize_all(const char *db_dir, int num_threads, int stale_hours) {
+    if (collect_databases(db_dir) < 0) return 1;
+    if (summary_count == 0) {
+        printf("No databases found in %s\n", db_dir);
+        return 0;
+    }
+
+    if (num_threads > summary_count) num_threads = summary_count;
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    int started = 0;
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&threads[started], NULL, summary_worker, NULL) == 0) started++;
+    }
+    // Fall back to reading on this thread if no worker could be started
+    if (started == 0) summary_worker(NULL);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    time_t now = time(NULL);
+    long long total_files = 0, total_changed = 0, total_new = 0, total_missing = 0, total_errors = 0;
+    int stale_count = 0, failed_count = 0;
+
+    print_all_header();
+    for (int i = 0; i < summary_count; i++) {
+        DbSummary *s = &summaries[i];
+        int stale = s->ok && s->runs_read > 0 &&
+                    (s->last_time == 0 || difftime(now, s->last_time) > stale_hours * 3600.0);
+        print_all_row(s, stale);
+
+        if (!s->ok || s->runs_read == 0) {
+            failed_count++;
+            continue;
+        }
+        if (stale) stale_count++;
+        total_files += (long long)s->unchanged + s->changed + s->new_files + s->moved;
+        total_changed += s->changed;
+        total_new += s->new_files;
+        total_missing += s->missing;
+        total_errors += s->errors;
+    }
+    print_separator(150);
+    printf("%-24s | %-19s | %-15s | %-6s | %'12lld | %'10lld | %'10lld | %'10lld | %'8lld |\n",
+           "TOTAL", "", "", "", total_files, total_changed, total_new, total_missing, total_errors);
+    print_separator(150);
+    printf("Databases: %d", summary_count);
+    if (stale_count > 0) printf(", %d stale (no run in %d hours)", stale_count, stale_hours);
+    if (failed_count > 0) printf(", %d unreadable or empty", failed_count);
+    printf("\n\n");
+
+    free(summaries);
+    return (stale_count > 0 || failed_count > 0) ? 2 : 0;
+}
+
+// ==== Performance report (--perf) ====
+// Runs are streamed oldest first; only the last window_runs of them are
+// held, so memory stays flat however many nightly runs meta has.
+#define PERF_MIN_POINTS 3       // runs needed before a trend is trusted
+#define CHURN_FLOOR_PCT 0.5     // churn below this is noise, never flagged
+
+enum { PERF_FILES_PER_SEC, PERF_BYTES_PER_SEC, PERF_CHURN, PERF_FILES, PERF_METRICS };
+const char *perf_keys[PERF_METRICS] = { "files_per_sec", "bytes_per_sec", "churn_pct", "files" };
+const char *perf_labels[PERF_METRICS] = { "files/s", "MB/s", "churn", "files" };
+
+typedef enum { PERF_TABLE, PERF_CSV, PERF_JSON } PerfFormat;
+
+// One meta row reduced to the report's figures. Values file_tracker did not
+// record (timings before they were added to meta) are NAN.
+typedef struct {
+    int id;
+    char date[20];
+    double seconds;
+    double files_delta, bytes, bytes_delta;
+    double metric[PERF_METRICS];
+    double deviation[PERF_METRICS];   // % off the previous runs' trend, NAN unless flagged
+    int flagged;
+} PerfRun;
+
+// Ring of the most recent window_runs runs; index 0 is the oldest
+typedef struct {
+    PerfRun runs[MAX_WINDOW];
+    int head, count;
+} PerfWindow;
+
+PerfRun *window_run(PerfWindow *w, int i) {
+    return &w->runs[(w->head + i) % window_runs];
+}
+
+void window_push(PerfWindow *w, const PerfRun *run) {
+    if (w->count < window_runs) {
+        *window_run(w, w->count++) = *run;
+    } else {
+        w->runs[w->head] = *run;
+        w->head = (w->head + 1) % window_runs;
+    }
+}
+
+// Least-squares line through the window's known values of one metric, x
+// being the run's position in the window. Returns the points used.
+int fit_trend(PerfWindow *w, int m, double *slope, double *intercept, double *mean) {
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int n = 0;
+    for (int i = 0; i < w->count; i++) {
+        double y = window_run(w, i)->metric[m];
+        if (isnan(y)) continue;
+        sx += i;
+        sy += y;
+        sxx += (double)i * i;
+        sxy += i * y;
+        n++;
+    }
+    *slope = *intercept = *mean = NAN;
+    if (n == 0) return 0;
+    *mean = sy / n;
+    double denom = n * sxx - sx * sx;
+    *slope = denom != 0 ? (n * sxy - sx * sy) / denom : 0;
+    *intercept = (sy - *slope * sx) / n;
+    return n;
+}
+
+double column_or_nan(sqlite3_stmt *stmt, int col) {
+    return sqlite3_column_type(stmt, col) == SQLITE_NULL ? NAN : sqlite3_column_double(stmt, col);
+}
+
+// Reduce a meta row (see prepare_meta_query) given the run before it
+void read_perf_run(sqlite3_stmt *stmt, const PerfRun *prev, PerfRun *run) {
+    memset(run, 0, sizeof(*run));
+    run->id = sqlite3_column_int(stmt, 0);
+    const char *checksum_date = (const char *)sqlite3_column_text(stmt, 1);
+    const char *verify_date = (const char *)sqlite3_column_text(stmt, 2);
+    const char *date = (checksum_date && strlen(checksum_date) > 0) ? checksum_date : verify_date;
+    snprintf(run->date, sizeof(run->date), "%s", date ? date : "");
+
+    long long unchanged = sqlite3_column_int64(stmt, 4);
+    long long changed = sqlite3_column_int64(stmt, 5);
+    long long new_files = sqlite3_column_int64(stmt, 6);
+    long long missing = sqlite3_column_int64(stmt, 7);
+    long long errors = sqlite3_column_int64(stmt, 8);
+    long long moved = sqlite3_column_int64(stmt, 10);
+
+    run->seconds = column_or_nan(stmt, 11);
+    if (run->seconds <= 0) run->seconds = NAN;
+    double files = column_or_nan(stmt, 12);
+    if (isnan(files)) files = unchanged + changed + new_files + moved;
+    run->bytes = column_or_nan(stmt, 13);
+
+    run->metric[PERF_FILES] = files;
+    run->metric[PERF_FILES_PER_SEC] = (unchanged + changed + new_files + moved + errors) / run->seconds;
+    run->metric[PERF_BYTES_PER_SEC] = column_or_nan(stmt, 14) / run->seconds;
+    run->files_delta = run->bytes_delta = run->metric[PERF_CHURN] = NAN;
+    if (prev) {
+        double prev_files = prev->metric[PERF_FILES];
+        run->files_delta = files - prev_files;
+        run->bytes_delta = run->bytes - prev->bytes;
+        if (prev_files > 0) run->metric[PERF_CHURN] = (changed + new_files + missing + moved) * 100.0 / prev_files;
+    }
+    for (int m = 0; m < PERF_METRICS; m++) run->deviation[m] = NAN;
+}
+
+// Compare the run against the line fitted through the runs before it. The
+// line's next value is kept within the range the window has seen, so a
+// steep slope over a few runs cannot predict a value never observed.
+void flag_deviations(PerfWindow *w, PerfRun *run, double threshold_pct) {
+    for (int m = 0; m < PERF_METRICS; m++) {
+        double slope, intercept, mean;
+        double actual = run->metric[m];
+        if (isnan(actual) || fit_trend(w, m, &slope, &intercept, &mean) < PERF_MIN_POINTS) continue;
+        double expected = intercept + slope * w->count;
+        double lo = NAN, hi = NAN;
+        for (int i = 0; i < w->count; i++) {
+            double y = window_run(w, i)->metric[m];
+            if (isnan(y)) continue;
+            if (isnan(lo) || y < lo) lo = y;
+            if (isnan(hi) || y > hi) hi = y;
+        }
+        if (expected < lo) expected = lo;
+        if (expected > hi) expected = hi;
+        if (expected <= 0) continue;
+        if (m == PERF_CHURN && actual < CHURN_FLOOR_PCT && expected < CHURN_FLOOR_PCT) continue;
+        double pct = (actual - expected) * 100.0 / expected;
+        if (pct > threshold_pct || pct < -threshold_pct) {
+            run->deviation[m] = pct;
+            run->flagged = 1;
+        }
+    }
+}
+
+// printf into buf, or "-" / "" / "null" when the value is unknown
+const char *fmt_value(char *buf, size_t size, const char *fmt, double value, const char *unknown) {
+    if (isnan(value)) return unknown;
+    snprintf(buf, size, fmt, value);
+    return buf;
+}
+
+void print_json_string(const char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') printf("\\%c", *s);
+        else if ((unsigned char)*s < 0x20) printf("\\u%04x", *s);
+        else putchar(*s);
+    }
+    putchar('"');
+}
+
+void print_perf_header(PerfFormat format, const char *db_name, double threshold_pct) {
+    if (format == PERF_CSV) {
+        printf("id,date,seconds,files,files_delta,bytes,bytes_delta,files_per_sec,bytes_per_sec,churn_pct,flags\n");
+    } else if (format == PERF_JSON) {
+        printf("{\"database\": ");
+        print_json_string(db_name);
+        printf(", \"window\": %d, \"threshold_pct\": %g, \"runs\": [", window_runs, threshold_pct);
+    } else {
+        printf("\n");
+        print_separator(140);
+        printf("%-6s | %-19s | %9s | %12s | %9s | %10s | %10s | %9s | %7s | %s\n",
+               "ID", "Date", "Seconds", "Files", "Growth", "GB", "Files/s", "MB/s", "Churn%", "Flags");
+        print_separator(140);
+    }
+}
+
+void print_perf_row(PerfFormat format, const PerfRun *r, int first) {
+    char b[PERF_METRICS + 4][32];
+    if (format == PERF_JSON) {
+        printf("%s\n  {\"id\": %d, \"date\": ", first ? "" : ",", r->id);
+        print_json_string(r->date);
+        printf(", \"seconds\": %s, \"files\": %.0f, \"files_delta\": %s, \"bytes\": %s, \"bytes_delta\": %s, "
+               "\"files_per_sec\": %s, \"bytes_per_sec\": %s, \"churn_pct\": %s, \"flags\": [",
+               fmt_value(b[0], 32, "%.3f", r->seconds, "null"), r->metric[PERF_FILES],
+               fmt_value(b[1], 32, "%.0f", r->files_delta, "null"),
+               fmt_value(b[2], 32, "%.0f", r->bytes, "null"),
+               fmt_value(b[3], 32, "%.0f", r->bytes_delta, "null"),
+               fmt_value(b[4], 32, "%.1f", r->metric[PERF_FILES_PER_SEC], "null"),
+               fmt_value(b[5], 32, "%.0f", r->metric[PERF_BYTES_PER_SEC], "null"),
+               fmt_value(b[6], 32, "%.3f", r->metric[PERF_CHURN], "null"));
+        int n = 0;
+        for (int m = 0; m < PERF_METRICS; m++) {
+            if (isnan(r->deviation[m])) continue;
+            printf("%s{\"metric\": \"%s\", \"deviation_pct\": %.1f}", n++ ? ", " : "", perf_keys[m], r->deviation[m]);
+        }
+        printf("]}");
+        return;
+    }
+
+    char flags[128] = "";
+    for (int m = 0; m < PERF_METRICS; m++) {
+        if (isnan(r->deviation[m])) continue;
+        size_t len = strlen(flags);
+        if (format == PERF_CSV) {
+            snprintf(flags + len, sizeof(flags) - len, "%s%s:%+.1f", len ? ";" : "", perf_keys[m], r->deviation[m]);
+        } else {
+            snprintf(flags + len, sizeof(flags) - len, "%s%s %+.0f%%", len ? ", " : "", perf_labels[m], r->deviation[m]);
+        }
+    }
+
+    if (format == PERF_CSV) {
+        printf("%d,%s,%s,%.0f,%s,%s,%s,%s,%s,%s,%s\n", r->id, r->date,
+               fmt_value(b[0], 32, "%.3f", r->seconds, ""), r->metric[PERF_FILES],
+               fmt_value(b[1], 32, "%.0f", r->files_delta, ""),
+               fmt_value(b[2], 32, "%.0f", r->bytes, ""),
+               fmt_value(b[3], 32, "%.0f", r->bytes_delta, ""),
+               fmt_value(b[4], 32, "%.1f", r->metric[PERF_FILES_PER_SEC], ""),
+               fmt_value(b[5], 32, "%.0f", r->metric[PERF_BYTES_PER_SEC], ""),
+               fmt_value(b[6], 32, "%.3f", r->metric[PERF_CHURN], ""),
+               flags);
+        return;
+    }
+
+    printf("%-6d | %-19s | %9s | %'12.0f | %9s | %10s | %10s | %9s | %7s | %s\n", r->id, r->date,
+           fmt_value(b[0], 32, "%.1f", r->seconds, "-"), r->metric[PERF_FILES],
+           fmt_value(b[1], 32, "%+'.0f", r->files_delta, "-"),
+           fmt_value(b[2], 32, "%'.1f", r->bytes / 1e9, "-"),
+           fmt_value(b[3], 32, "%'.1f", r->metric[PERF_FILES_PER_SEC], "-"),
+           fmt_value(b[4], 32, "%'.1f", r->metric[PERF_BYTES_PER_SEC] / 1e6, "-"),
+           fmt_value(b[5], 32, "%.2f", r->metric[PERF_CHURN], "-"),
+           flags);
+}
+
+// Trend of the last window_runs runs: mean and slope per run of each metric
+void print_perf_trend(PerfFormat format, PerfWindow *w, int rows) {
+    if (format == PERF_CSV) return;
+    if (format == PERF_JSON) printf("\n], \"trend\": {");
+    else {
+        print_separator(140);
+        printf("Runs: %d    Trend over the last %d:\n", rows, w->count);
+    }
+
+    for (int m = 0; m < PERF_METRICS; m++) {
+        double slope, intercept, mean;
+        int n = fit_trend(w, m, &slope, &intercept, &mean);
+        if (format == PERF_JSON) {
+            char b[3][32];
+            printf("%s\"%s\": {\"points\": %d, \"mean\": %s, \"slope_per_run\": %s}", m ? ", " : "", perf_keys[m], n,
+                   fmt_value(b[0], 32, "%.3f", mean, "null"),
+                   fmt_value(b[1], 32, "%.3f", n >= 2 ? slope : NAN, "null"));
+            continue;
+        }
+        if (n < 2) {
+            printf("  %-8s not enough runs with this figure recorded\n", perf_labels[m]);
+            continue;
+        }
+        double scale = m == PERF_BYTES_PER_SEC ? 1e6 : 1;
+        printf("  %-8s mean %'14.2f   slope %+'12.2f/run", perf_labels[m], mean / scale, slope / scale);
+        if (mean != 0) printf(" (%+.2f%%/run)", slope * 100.0 / mean);
+        printf("\n");
+    }
+    if (format == PERF_JSON) printf("}}\n");
+    else printf("\n");
+}
+
+// Per-run throughput, growth and churn with deviations from the trend.
+// Returns 2 when the latest run is flagged, so cron jobs can alert on it.
+int perf_report(sqlite3 *db, const char *db_name, int show_all, PerfFormat format, double threshold_pct) {
+    // Without -a only the last window_runs runs are shown, but the window
+    // before them is read too so the first shown run has a trend to meet
+    long long total = 0, skip = 0;
+    char suffix[160] = "ORDER BY id ASC";
+    if (!show_all) {
+        sqlite3_stmt *cstmt;
+        if (sqlite3_prepare_v2(db, "SELECT count(*) FROM meta", -1, &cstmt, NULL) == SQLITE_OK) {
+            if (sqlite3_step(cstmt) == SQLITE_ROW) total = sqlite3_column_int64(cstmt, 0);
+            sqlite3_finalize(cstmt);
+        }
+        int lookback = 2 * window_runs + 1;
+        if (total > lookback) total = lookback;
+        skip = total > window_runs ? total - window_runs : 0;
+        snprintf(suffix, sizeof(suffix),
+                 "WHERE id IN (SELECT id FROM meta ORDER BY id DESC LIMIT %d) ORDER BY id ASC", lookback);
+    }
+
+    sqlite3_stmt *stmt;
+    if (prepare_meta_query(db, suffix, &stmt) != SQLITE_OK) {
+        fprintf(stderr, "Error: Failed to prepare query: %s\n", sqlite3_errmsg(db));
+        return 1;
+    }
+
+    PerfWindow *w = calloc(1, sizeof(PerfWindow));
+    PerfRun run, prev;
+    long long rows = 0;
+    int shown = 0, last_flagged = 0;
+
+    print_perf_header(format, db_name, threshold_pct);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        read_perf_run(stmt, rows > 0 ? &prev : NULL, &run);
+        flag_deviations(w, &run, threshold_pct);
+        if (rows++ >= skip) {
+            print_perf_row(format, &run, shown++ == 0);
+            last_flagged = run.flagged;
+        }
+        window_push(w, &run);
+        prev = run;
+    }
+    sqlite3_finalize(stmt);
+
+    print_perf_trend(format, w, shown);
+    free(w);
+    return last_flagged ? 2 : 0;
+}
+
 int main(int argc, char *argv[]) {
     char *db_name = NULL;
     int show_all = 0;
+    int all_databases = 0;
+    int num_threads = 8;
+    int stale_hours = 36;
+    int perf = 0;
+    PerfFormat perf_format = PERF_TABLE;
+    double threshold_pct = 25;
 
     // Enable locale for thousand separators
     setlocale(LC_NUMERIC, "");
@@ -104,6 +700,25 @@ int main(int argc, char *argv[]) {
             db_name = argv[++i];
         } else if (strcmp(argv[i], "-a") == 0) {
             show_all = 1;
+        } else if (strcmp(argv[i], "--all") == 0) {
+            all_databases = 1;
+        } else if (strcmp(argv[i], "--perf") == 0) {
+            perf = 1;
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            perf_format = PERF_CSV;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            perf_format = PERF_JSON;
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            threshold_pct = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            window_runs = atoi(argv[++i]);
+            if (window_runs < 1) window_runs = 1;
+            if (window_runs > MAX_WINDOW) window_runs = MAX_WINDOW;
+        } else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) {
+            stale_hours = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+            if (num_threads < 1) num_threads = 1;
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -114,8 +729,13 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if (!db_name) {
-        fprintf(stderr, "Error: -d option is required\n\n");
+    if (!db_name && !all_databases) {
+        fprintf(stderr, "Error: -d or --all option is required\n\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (perf && !db_name) {
+        fprintf(stderr, "Error: --perf requires -d\n\n");
         print_usage(argv[0]);
         return 1;
     }
@@ -127,6 +747,12 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    if (all_databases) {
+        char db_dir[MAX_PATH];
+        snprintf(db_dir, sizeof(db_dir), "%s/db/FileTracker", home);
+        return summarize_all(db_dir, num_threads, stale_hours);
+    }
+
     char db_path[MAX_PATH];
     snprintf(db_path, sizeof(db_path), "%s/db/FileTracker/%s.db", home, db_name);
 
@@ -137,36 +763,24 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    // Open database (need write access to potentially add column)
+    // Open database read-only; schema migration is file_tracker's job
     sqlite3 *db;
-    if (sqlite3_open(db_path, &db) != SQLITE_OK) {
+    if (open_readonly(db_path, &db) != SQLITE_OK) {
         fprintf(stderr, "Error: Failed to open database: %s\n", sqlite3_errmsg(db));
         return 1;
     }
 
-    // Migrate: Add update_mode column if it doesn't exist (for backward compatibility)
-    // This will fail silently if column already exists, which is fine
-    char *err_msg = NULL;
-    sqlite3_exec(db, "ALTER TABLE meta ADD COLUMN update_mode TEXT", NULL, NULL, &err_msg);
-    if (err_msg) {
-        // Ignore "duplicate column name" error - it just means column already exists
-        sqlite3_free(err_msg);
+    if (perf) {
+        // Machine-readable output keeps '.' decimals and no grouping
+        if (perf_format != PERF_TABLE) setlocale(LC_NUMERIC, "C");
+        int status = perf_report(db, db_name, show_all, perf_format, threshold_pct);
+        sqlite3_close(db);
+        return status;
     }
 
     // Query meta table
-    const char *query;
-    if (show_all) {
-        query = "SELECT id, last_checksum_verify_date, last_date_verify, verify_machine, "
-                "num_unchanged, num_changed, num_new, num_missing, num_errors, update_mode "
-                "FROM meta ORDER BY id ASC";
-    } else {
-        query = "SELECT id, last_checksum_verify_date, last_date_verify, verify_machine, "
-                "num_unchanged, num_changed, num_new, num_missing, num_errors, update_mode "
-                "FROM meta ORDER BY id DESC LIMIT 1";
-    }
-
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db, query, -1, &stmt, NULL);
+    int rc = prepare_meta_query(db, show_all ? "ORDER BY id ASC" : "ORDER BY id DESC LIMIT 1", &stmt);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Error: Failed to prepare query: %s\n", sqlite3_errmsg(db));
         sqlite3_close(db);
@@ -0,0 +1,892 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <locale.h>
+#include <openssl/evp.h>
+#include <pthread.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+
+#define HASH_SIZE 80     // "m<chunk MiB>:" + 64 hex digits for tree hashes
+#define MAX_PATH 4096
+#define MAX_SHARDS 8
+#define MAX_IGNORES 1024
+#define CHUNK_DIGEST_SIZE 32
+#define HASH_XATTR "user.file_tracker.hash"
+// Written only by ft_verify -x, after reading the copy itself. The
+// file_tracker xattr is copied from the source along with the mtime, so it
+// says nothing about the bytes in the backup.
+#define VERIFY_XATTR "user.ft_verify.hash"
+
+// ==== Globals ====
+int verbose = 0;
+int num_threads = 4;
+int trust_xattr = 0;
+
+char source_root[MAX_PATH];
+// Rows under the root: full_path in ("<root>/", "<root>0"), '0' being '/' + 1
+char root_lo[MAX_PATH], root_hi[MAX_PATH];
+
+// A backup tree to check. With -r these are Base and every *_Incremental
+// and *_Snapshot directory under the backup root, checked one at a time.
+typedef enum {
+    TREE_MIRROR,        // should match the database now: -b, or Base
+    TREE_PAST,          // an older *_Incremental; only copies still matching their row are checked
+    TREE_MANIFEST       // an ft_backup snapshot, checked against its own <dir>.manifest
+} TreeKind;
+
+typedef struct {
+    char path[MAX_PATH];
+    char label[256];    // prefix of reported paths: "" for -b, "<dir>/" for -r
+    TreeKind kind;
+} BackupTree;
+
+BackupTree *trees = NULL;
+int tree_count = 0;
+int current_tree = 0;
+
+char *ignore_list[MAX_IGNORES];
+int ignore_count = 0;
+
+// One backup file to check against its database row
+typedef struct {
+    char *rel_path;
+    long long size;
+    char expected[HASH_SIZE];
+    int chunk_mib;      // format of expected: tree hash chunk size, 0 for a plain SHA-256
+    unsigned char *expected_chunks;     // per-chunk digests of a tree hash, if stored
+    int expected_chunk_count;
+    dev_t dev;
+    ino_t ino;
+    long long mtime_ns;     // when queued, to tag the copy with what was read
+    int inode_task;     // index into tasks, shared by the hardlinks to the inode whose rows use the same format
+} VerifyJob;
+
+// One inode to hash; hardlinked snapshot files are only read once
+typedef struct {
+    int job;            // first job on this inode, supplies the path and size
+    char actual[HASH_SIZE];
+    int chunk_mib;      // > 0 for a tree hash, whose chunks are hashed separately
+    int chunk_count;
+    int failed;
+    int reused;         // hashed in an earlier tree; digests belong to inode_results
+    unsigned char *digests;
+} HashTask;
+
+// One unit of work for the pool: a whole file, or one chunk of a tree hash
+typedef struct {
+    int task;
+    int chunk;          // -1 for a whole file
+} HashUnit;
+
+VerifyJob *jobs = NULL;
+int job_count = 0, job_capacity = 0;
+HashTask *tasks = NULL;
+int *task_order = NULL;     // task indexes, largest file first
+int task_count = 0;
+HashUnit *units = NULL;
+int unit_count = 0;
+int next_unit = 0;
+
+// Hashes from earlier trees, by inode. Snapshots hardlink unchanged files
+// to each other, so each inode is read once however many trees share it.
+typedef struct InodeResult {
+    dev_t dev;
+    ino_t ino;
+    int chunk_mib;
+    char actual[HASH_SIZE];
+    unsigned char *digests;
+    struct InodeResult *next;
+} InodeResult;
+
+#define INODE_BUCKETS 65536
+InodeResult *inode_results[INODE_BUCKETS];
+
+int num_ok = 0, num_missing = 0, num_corrupted = 0, num_extra = 0, num_unchecked = 0, num_errors = 0, num_cached = 0;
+int num_outdated = 0, inodes_hashed = 0;
+long long bytes_hashed = 0;
+
+pthread_mutex_t task_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t count_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void print_usage(const char *prog_name) {
+    fprintf(stderr, "Usage: %s -p <source> {-b <backup_dir> | -r <backup_root>} [-d db_name] [-t threads] [-x] [-v]\n", prog_name);
+    fprintf(stderr, "  -p <source>  Path that was scanned by file_tracker\n");
+    fprintf(stderr, "  -b <dir>     Backup copy of the source (e.g. Base or a snapshot)\n");
+    fprintf(stderr, "  -r <root>    Backup root: check Base and every *_Incremental and *_Snapshot\n");
+    fprintf(stderr, "               in it, reading each hardlinked inode only once\n");
+    fprintf(stderr, "  -d <name>    Database name (default: basename of the source, without .db)\n");
+    fprintf(stderr, "  -t <num>     Files hashed in parallel (default 4)\n");
+    fprintf(stderr, "  -x           Skip copies an earlier ft_verify -x run read in full, while their size and\n");
+    fprintf(stderr, "               mtime are unchanged, and tag the copies it reads (%s).\n", VERIFY_XATTR);
+    fprintf(stderr, "               Bit rot since that earlier run is NOT detected in the skipped copies.\n");
+    fprintf(stderr, "               The %s copied from the source is never trusted.\n", HASH_XATTR);
+    fprintf(stderr, "  -v           Verbose output\n");
+}
+
+// ==== Ignore List Helpers ====
+void load_ignore_list() {
+    const char *home = getenv("HOME");
+    char ignore_path[MAX_PATH];
+    snprintf(ignore_path, sizeof(ignore_path), "%s/.rsync-ignore", home);
+
+    FILE *f = fopen(ignore_path, "r");
+    if (!f) return;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f) && ignore_count < MAX_IGNORES) {
+        line[strcspn(line, "\r\n")] = 0;
+        if (strlen(line) > 0) {
+            ignore_list[ignore_count++] = strdup(line);
+        }
+    }
+    fclose(f);
+}
+
+int is_ignored(const char *name) {
+    if (strcmp(name, ".DS_Store") == 0 || strcmp(name, "LastSyncDate") == 0) return 1;
+    for (int i = 0; i < ignore_count; i++) {
+        if (strcmp(name, ignore_list[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// ==== Utility Functions ====
+void compute_sha256(const char *path, char *outputBuffer) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        strcpy(outputBuffer, "");
+        return;
+    }
+    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_len;
+    EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL);
+    const int bufSize = 1 << 20;
+    unsigned char *buffer = malloc(bufSize);
+    int bytesRead;
+    while ((bytesRead = fread(buffer, 1, bufSize, file))) {
+        EVP_DigestUpdate(mdctx, buffer, bytesRead);
+    }
+    EVP_DigestFinal_ex(mdctx, hash, &hash_len);
+    for (unsigned int i = 0; i < hash_len; i++) {
+        sprintf(outputBuffer + (i * 2), "%02x", hash[i]);
+    }
+    outputBuffer[hash_len * 2] = '\0';
+    EVP_MD_CTX_free(mdctx);
+    fclose(file);
+    free(buffer);
+}
+
+// Chunk size of a tree hash checksum written by "file_tracker -M", 0 for a
+// plain SHA-256
+int checksum_chunk_mib(const char *checksum) {
+    if (!checksum || checksum[0] != 'm') return 0;
+    char *end;
+    long mib = strtol(checksum + 1, &end, 10);
+    return (*end == ':' && mib > 0) ? (int)mib : 0;
+}
+
+// SHA-256 of one chunk of a file. Returns 0 on success.
+int hash_chunk(const char *path, long long offset, long long length, unsigned char *digest) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    const size_t bufSize = 1 << 20;
+    unsigned char *buffer = malloc(bufSize);
+    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
+    ssize_t n = 0;
+    EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL);
+    while (buffer && length > 0) {
+        n = pread(fd, buffer, length < (long long)bufSize ? (size_t)length : bufSize, offset);
+        if (n <= 0) break;
+        EVP_DigestUpdate(mdctx, buffer, n);
+        offset += n;
+        length -= n;
+    }
+    EVP_DigestFinal_ex(mdctx, digest, NULL);
+    EVP_MD_CTX_free(mdctx);
+    free(buffer);
+    close(fd);
+    return (buffer && length == 0) ? 0 : -1;
+}
+
+// Root of a tree hash: SHA-256 of the concatenated chunk digests
+void tree_root(const HashTask *task, char *checksum) {
+    unsigned char root[EVP_MAX_MD_SIZE];
+    unsigned int root_len;
+    EVP_Digest(task->digests, (size_t)task->chunk_count * CHUNK_DIGEST_SIZE, root, &root_len, EVP_sha256(), NULL);
+    int len = snprintf(checksum, HASH_SIZE, "m%d:", task->chunk_mib);
+    for (unsigned int i = 0; i < root_len; i++) {
+        sprintf(checksum + len + (i * 2), "%02x", root[i]);
+    }
+}
+
+long long mtime_ns(const struct stat *st) {
+#ifdef __APPLE__
+    return st->st_mtimespec.tv_sec * 1000000000LL + st->st_mtimespec.tv_nsec;
+#else
+    return st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+#endif
+}
+
+// Checksum an earlier "ft_verify -x" stored on the copy, if it was computed
+// from the copy's current size and mtime. Returns 1 and fills checksum if so.
+int cached_checksum(const char *path, const struct stat *st, char *checksum) {
+    char value[256], algorithm[16], hash[HASH_SIZE];
+    long long size, mtime;
+#ifdef __APPLE__
+    ssize_t n = getxattr(path, VERIFY_XATTR, value, sizeof(value) - 1, 0, 0);
+#else
+    ssize_t n = getxattr(path, VERIFY_XATTR, value, sizeof(value) - 1);
+#endif
+    if (n <= 0) return 0;
+    value[n] = '\0';
+    if (sscanf(value, "%15s %79s %lld %lld", algorithm, hash, &size, &mtime) != 4) return 0;
+    if (strcmp(algorithm, "sha256") != 0 || strlen(hash) < 64) return 0;
+    if (size != (long long)st->st_size || mtime != mtime_ns(st)) return 0;
+    snprintf(checksum, HASH_SIZE, "%s", hash);
+    return 1;
+}
+
+// Record what was just read from a copy, unless it changed while being read
+void store_checksum(const char *path, const VerifyJob *job, const char *checksum) {
+    struct stat now;
+    if (stat(path, &now) != 0 || now.st_size != job->size || mtime_ns(&now) != job->mtime_ns) return;
+    char value[256];
+    int len = snprintf(value, sizeof(value), "sha256 %s %lld %lld", checksum, job->size, job->mtime_ns);
+#ifdef __APPLE__
+    setxattr(path, VERIFY_XATTR, value, len, 0, 0);
+#else
+    setxattr(path, VERIFY_XATTR, value, len, 0);
+#endif
+}
+
+void report(const char *status, const char *rel_path) {
+    printf("[%-9s] %s%s\n", status, trees[current_tree].label, rel_path);
+}
+
+size_t inode_bucket(dev_t dev, ino_t ino) {
+    return ((size_t)ino * 31 + (size_t)dev) % INODE_BUCKETS;
+}
+
+const InodeResult *inode_result_get(dev_t dev, ino_t ino, int chunk_mib) {
+    for (const InodeResult *r = inode_results[inode_bucket(dev, ino)]; r; r = r->next) {
+        if (r->dev == dev && r->ino == ino && r->chunk_mib == chunk_mib) return r;
+    }
+    return NULL;
+}
+
+// Takes ownership of digests
+void inode_result_put(dev_t dev, ino_t ino, int chunk_mib, const char *actual, unsigned char *digests) {
+    InodeResult *r = malloc(sizeof(InodeResult));
+    if (!r) {
+        free(digests);
+        return;
+    }
+    size_t b = inode_bucket(dev, ino);
+    r->dev = dev;
+    r->ino = ino;
+    r->chunk_mib = chunk_mib;
+    snprintf(r->actual, sizeof(r->actual), "%s", actual);
+    r->digests = digests;
+    r->next = inode_results[b];
+    inode_results[b] = r;
+}
+
+// ==== Hashing ====
+void *hash_worker(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&task_mutex);
+        int n = next_unit++;
+        pthread_mutex_unlock(&task_mutex);
+        if (n >= unit_count) break;
+        HashTask *task = &tasks[units[n].task];
+
+        VerifyJob *job = &jobs[task->job];
+        char path[MAX_PATH];
+        long long bytes = job->size;
+        if (snprintf(path, sizeof(path), "%s/%s", trees[current_tree].path, job->rel_path) >= (int)sizeof(path)) {
+            // Never queued by verify_tree; leave actual empty so it is reported
+            bytes = 0;
+            pthread_mutex_lock(&count_mutex);
+            task->failed = 1;
+            pthread_mutex_unlock(&count_mutex);
+        } else if (units[n].chunk < 0) {
+            compute_sha256(path, task->actual);
+        } else {
+            long long chunk_bytes = (long long)task->chunk_mib << 20;
+            long long offset = units[n].chunk * chunk_bytes;
+            if (bytes - offset < chunk_bytes) chunk_bytes = bytes - offset;
+            bytes = chunk_bytes;
+            if (hash_chunk(path, offset, chunk_bytes, task->digests + (size_t)units[n].chunk * CHUNK_DIGEST_SIZE) != 0) {
+                pthread_mutex_lock(&count_mutex);
+                task->failed = 1;
+                pthread_mutex_unlock(&count_mutex);
+            }
+        }
+
+        pthread_mutex_lock(&count_mutex);
+        bytes_hashed += bytes;
+        pthread_mutex_unlock(&count_mutex);
+    }
+    return NULL;
+}
+
+// Hardlinks share a hash task only if their rows use the same hash format:
+// rows written with different -M settings need the inode hashed both ways
+int compare_by_inode(const void *a, const void *b) {
+    const VerifyJob *x = a, *y = b;
+    if (x->dev != y->dev) return x->dev < y->dev ? -1 : 1;
+    if (x->ino != y->ino) return x->ino < y->ino ? -1 : 1;
+    if (x->chunk_mib != y->chunk_mib) return x->chunk_mib < y->chunk_mib ? -1 : 1;
+    return 0;
+}
+
+// Largest files first, so one huge file does not start last and leave a long tail
+int compare_tasks_by_size(const void *a, const void *b) {
+    long long x = jobs[tasks[*(const int *)a].job].size;
+    long long y = jobs[tasks[*(const int *)b].job].size;
+    return (x < y) - (x > y);
+}
+
+void add_job(const char *rel_path, long long size, const char *expected,
+             const void *chunks, int chunks_len, const struct stat *st) {
+    if (job_count >= job_capacity) {
+        job_capacity = job_capacity == 0 ? 256 : job_capacity * 2;
+        jobs = realloc(jobs, job_capacity * sizeof(VerifyJob));
+    }
+    VerifyJob *job = &jobs[job_count++];
+    job->rel_path = strdup(rel_path);
+    job->size = size;
+    snprintf(job->expected, sizeof(job->expected), "%s", expected);
+    job->chunk_mib = checksum_chunk_mib(expected);
+    job->expected_chunks = NULL;
+    job->expected_chunk_count = 0;
+    if (chunks && chunks_len > 0 && chunks_len % CHUNK_DIGEST_SIZE == 0) {
+        job->expected_chunks = malloc(chunks_len);
+        if (job->expected_chunks) {
+            memcpy(job->expected_chunks, chunks, chunks_len);
+            job->expected_chunk_count = chunks_len / CHUNK_DIGEST_SIZE;
+        }
+    }
+    job->dev = st->st_dev;
+    job->ino = st->st_ino;
+    job->mtime_ns = mtime_ns(st);
+    job->inode_task = -1;
+}
+
+// ==== Database ====
+// Databases written with "file_tracker -S" keep rows in <name>.shard<k>.db
+// next to <name>.db. Attach them and expose every row as tracked_files.
+// file_tracker stamps every shard with the same run_id and commits shard 0
+// last, so a shard whose run_id differs from shard 0's was left by a run that
+// did not finish; it is reported and -2 returned.
+// Databases last written before tree hashing have no chunk_hashes column.
+void read_run_id(sqlite3 *db, const char *schema, char *run_id, size_t size) {
+    char sql[128];
+    sqlite3_stmt *stmt;
+    run_id[0] = '\0';
+    snprintf(sql, sizeof(sql), "SELECT value FROM %s.metadata WHERE key = 'run_id'", schema);
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) return;
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0)) {
+        snprintf(run_id, size, "%s", (const char *)sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+}
+
+int attach_shards(sqlite3 *db, const char *db_path) {
+    char sql[2048];
+    sqlite3_stmt *probe;
+    const char *chunks = "NULL AS chunk_hashes";
+    if (sqlite3_prepare_v2(db, "SELECT chunk_hashes FROM main.files LIMIT 0", -1, &probe, NULL) == SQLITE_OK) {
+        chunks = "chunk_hashes";
+        sqlite3_finalize(probe);
+    }
+    int len = snprintf(sql, sizeof(sql),
+                       "CREATE TEMP VIEW tracked_files AS SELECT full_path, size, last_modified, checksum, %s FROM main.files", chunks);
+    size_t base_len = strlen(db_path) - 3;
+    char main_run[64];
+    read_run_id(db, "main", main_run, sizeof(main_run));
+    for (int k = 1; k < MAX_SHARDS; k++) {
+        char shard_path[MAX_PATH], attach[64], schema[16], shard_run[64];
+        snprintf(shard_path, sizeof(shard_path), "%.*s.shard%d.db", (int)base_len, db_path, k);
+        if (access(shard_path, F_OK) != 0) break;
+
+        sqlite3_stmt *stmt;
+        snprintf(attach, sizeof(attach), "ATTACH DATABASE ? AS shard%d", k);
+        if (sqlite3_prepare_v2(db, attach, -1, &stmt, NULL) != SQLITE_OK) return -1;
+        sqlite3_bind_text(stmt, 1, shard_path, -1, SQLITE_STATIC);
+        int rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) return -1;
+
+        snprintf(schema, sizeof(schema), "shard%d", k);
+        read_run_id(db, schema, shard_run, sizeof(shard_run));
+        if (main_run[0] && strcmp(main_run, shard_run) != 0) {
+            fprintf(stderr, "Error: %s was left by an unfinished file_tracker run; run file_tracker -u again\n", shard_path);
+            return -2;
+        }
+
+        len += snprintf(sql + len, sizeof(sql) - len,
+                        " UNION ALL SELECT full_path, size, last_modified, checksum, %s FROM shard%d.files", chunks, k);
+    }
+    return sqlite3_exec(db, sql, 0, 0, 0) == SQLITE_OK ? 0 : -1;
+}
+
+// Name the chunks of a corrupted tree-hashed file that differ from the
+// digests file_tracker stored, so only those byte ranges need repair
+void report_chunks(const VerifyJob *job, const HashTask *task) {
+    if (!job->expected_chunks || job->expected_chunk_count != task->chunk_count) return;
+    long long chunk_bytes = (long long)task->chunk_mib << 20;
+    for (int c = 0; c < task->chunk_count; c++) {
+        if (memcmp(job->expected_chunks + (size_t)c * CHUNK_DIGEST_SIZE,
+                   task->digests + (size_t)c * CHUNK_DIGEST_SIZE, CHUNK_DIGEST_SIZE) != 0) {
+            long long end = (c + 1) * chunk_bytes < job->size ? (c + 1) * chunk_bytes : job->size;
+            printf("            chunk %d of %d (bytes %lld-%lld)\n", c + 1, task->chunk_count, c * chunk_bytes, end - 1);
+        }
+    }
+}
+
+// ==== Extra files ====
+// Walk a backup tree and report regular files its database or manifest does
+// not know about. Rows are looked up as <prefix><path relative to the tree>.
+void find_extras(const char *dir_path, sqlite3_stmt *lookup, const char *prefix) {
+    DIR *dir = opendir(dir_path);
+    if (!dir) return;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        if (is_ignored(entry->d_name)) continue;
+
+        char full_path[MAX_PATH];
+        struct stat st;
+        int path_len = snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, entry->d_name);
+        if (path_len >= (int)sizeof(full_path) || lstat(full_path, &st) != 0) continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            find_extras(full_path, lookup, prefix);
+        } else if (S_ISREG(st.st_mode)) {
+            const char *rel_path = full_path + strlen(trees[current_tree].path) + 1;
+            char source_path[MAX_PATH];
+            if (snprintf(source_path, sizeof(source_path), "%s%s", prefix, rel_path) >= (int)sizeof(source_path)) {
+                fprintf(stderr, "Error: Path too long, not checked: %s\n", full_path);
+                num_errors++;
+                continue;
+            }
+            sqlite3_bind_text(lookup, 1, source_path, -1, SQLITE_STATIC);
+            if (sqlite3_step(lookup) != SQLITE_ROW) {
+                report("EXTRA", rel_path);
+                num_extra++;
+            }
+            sqlite3_reset(lookup);
+        }
+    }
+    closedir(dir);
+}
+
+void strip_trailing_slashes(char *path) {
+    size_t len = strlen(path);
+    while (len > 1 && path[len - 1] == '/') path[--len] = '\0';
+}
+
+// ==== Backup trees ====
+void add_tree(const char *root, const char *name, TreeKind kind) {
+    BackupTree *grown = realloc(trees, (tree_count + 1) * sizeof(BackupTree));
+    if (!grown) return;
+    trees = grown;
+    BackupTree *tree = &trees[tree_count];
+    int path_len = snprintf(tree->path, sizeof(tree->path), "%s/%s", root, name);
+    int label_len = snprintf(tree->label, sizeof(tree->label), "%s/", name);
+    if (path_len >= (int)sizeof(tree->path) || label_len >= (int)sizeof(tree->label)) {
+        fprintf(stderr, "Warning: Path too long, skipping: %s/%s\n", root, name);
+        return;
+    }
+    tree->kind = kind;
+    tree_count++;
+}
+
+int has_suffix(const char *name, const char *suffix) {
+    size_t len = strlen(name), suffix_len = strlen(suffix);
+    return len > suffix_len && strcmp(name + len - suffix_len, suffix) == 0;
+}
+
+int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Base, then the *_Incremental and *_Snapshot directories of a backup root
+// in name order; their date stamps sort by time
+int find_trees(const char *root) {
+    DIR *dir = opendir(root);
+    if (!dir) return -1;
+    char **names = NULL;
+    int name_count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        if (!has_suffix(entry->d_name, "_Incremental") && !has_suffix(entry->d_name, "_Snapshot")) continue;
+        char **grown = realloc(names, (name_count + 1) * sizeof(char *));
+        if (!grown) break;
+        names = grown;
+        names[name_count++] = strdup(entry->d_name);
+    }
+    closedir(dir);
+    qsort(names, name_count, sizeof(char *), compare_names);
+
+    char path[MAX_PATH];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/Base", root);
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) add_tree(root, "Base", TREE_MIRROR);
+    for (int i = 0; i < name_count; i++) {
+        int path_len = snprintf(path, sizeof(path), "%s/%s", root, names[i]);
+        if (path_len < (int)sizeof(path) && stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            if (!has_suffix(names[i], "_Snapshot")) {
+                add_tree(root, names[i], TREE_PAST);
+            } else {
+                // Snapshots without a manifest were made by rsync, like the incrementals
+                int manifest_len = snprintf(path, sizeof(path), "%s/%s.manifest", root, names[i]);
+                int has_manifest = manifest_len < (int)sizeof(path) && access(path, F_OK) == 0;
+                add_tree(root, names[i], has_manifest ? TREE_MANIFEST : TREE_PAST);
+            }
+        }
+        free(names[i]);
+    }
+    free(names);
+    return 0;
+}
+
+// ==== Verification ====
+// Check one backup tree. Jobs, tasks and units only live for the tree;
+// inode_results carries hashes over to the trees after it.
+void verify_tree(sqlite3 *db) {
+    const BackupTree *tree = &trees[current_tree];
+    sqlite3 *manifest_db = NULL;
+    sqlite3_stmt *stmt = NULL, *lookup = NULL;
+    const char *lookup_prefix = "";
+    size_t strip_len = 0;
+
+    if (tree->kind == TREE_MANIFEST) {
+        char manifest_path[MAX_PATH];
+        if (snprintf(manifest_path, sizeof(manifest_path), "%s.manifest", tree->path) >= (int)sizeof(manifest_path) ||
+            sqlite3_open_v2(manifest_path, &manifest_db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK ||
+            sqlite3_prepare_v2(manifest_db, "SELECT path, size, last_modified, checksum, NULL FROM snapshot_files", -1, &stmt, NULL) != SQLITE_OK) {
+            fprintf(stderr, "Error: Failed to read manifest %s: %s\n", manifest_path, sqlite3_errmsg(manifest_db));
+            num_errors++;
+            sqlite3_close(manifest_db);
+            return;
+        }
+        if (sqlite3_prepare_v2(manifest_db, "SELECT 1 FROM snapshot_files WHERE path = ?", -1, &lookup, NULL) != SQLITE_OK) lookup = NULL;
+    } else {
+        if (sqlite3_prepare_v2(db, "SELECT full_path, size, last_modified, checksum, chunk_hashes FROM tracked_files WHERE full_path > ? AND full_path < ?", -1, &stmt, NULL) != SQLITE_OK) {
+            fprintf(stderr, "Error: Failed to query database: %s\n", sqlite3_errmsg(db));
+            num_errors++;
+            return;
+        }
+        sqlite3_bind_text(stmt, 1, root_lo, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, root_hi, -1, SQLITE_STATIC);
+        strip_len = strlen(source_root) + 1;
+        // Files added or deleted since an older tree was taken are not its faults
+        if (tree->kind == TREE_MIRROR &&
+            sqlite3_prepare_v2(db, "SELECT 1 FROM tracked_files WHERE full_path = ?", -1, &lookup, NULL) != SQLITE_OK) lookup = NULL;
+        lookup_prefix = root_lo;
+    }
+
+    // Size mismatches and missing copies need no reads
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *rel_path = (const char *)sqlite3_column_text(stmt, 0) + strip_len;
+        long long size = sqlite3_column_int64(stmt, 1);
+        long long mtime = sqlite3_column_int64(stmt, 2);
+        const char *checksum = (const char *)sqlite3_column_text(stmt, 3);
+
+        char backup_path[MAX_PATH], cached[HASH_SIZE];
+        struct stat st;
+        if (snprintf(backup_path, sizeof(backup_path), "%s/%s", tree->path, rel_path) >= (int)sizeof(backup_path)) {
+            fprintf(stderr, "Error: Path too long, not checked: %s/%s\n", tree->path, rel_path);
+            num_errors++;
+        } else if (stat(backup_path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            if (tree->kind != TREE_PAST) {
+                report("MISSING", rel_path);
+                num_missing++;
+            }
+        } else if (tree->kind == TREE_PAST && (st.st_size != size || (long long)st.st_mtime != mtime)) {
+            // An older version of the file, which the database has no checksum for
+            if (verbose) report("OUTDATED", rel_path);
+            num_outdated++;
+        } else if (st.st_size != size) {
+            report("CORRUPTED", rel_path);
+            num_corrupted++;
+        } else if (!checksum || !checksum[0]) {
+            if (verbose) report("UNCHECKED", rel_path);
+            num_unchecked++;
+        } else if (trust_xattr && cached_checksum(backup_path, &st, cached) &&
+                   checksum_chunk_mib(cached) == checksum_chunk_mib(checksum)) {
+            // Read in full by an earlier run, and untouched since
+            num_cached++;
+            if (strcmp(cached, checksum) != 0) {
+                report("CORRUPTED", rel_path);
+                num_corrupted++;
+            } else {
+                if (verbose) report("OK", rel_path);
+                num_ok++;
+            }
+        } else {
+            add_job(rel_path, size, checksum, sqlite3_column_blob(stmt, 4), sqlite3_column_bytes(stmt, 4), &st);
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    // One hash task per inode and format, unless an earlier tree already hashed it
+    qsort(jobs, job_count, sizeof(VerifyJob), compare_by_inode);
+    tasks = malloc((job_count > 0 ? job_count : 1) * sizeof(HashTask));
+    for (int i = 0; i < job_count; i++) {
+        if (i > 0 && compare_by_inode(&jobs[i - 1], &jobs[i]) == 0) {
+            jobs[i].inode_task = jobs[i - 1].inode_task;
+            continue;
+        }
+        HashTask *task = &tasks[task_count];
+        task->job = i;
+        task->actual[0] = '\0';
+        task->chunk_mib = jobs[i].chunk_mib;
+        task->chunk_count = 0;
+        task->failed = 0;
+        task->reused = 0;
+        task->digests = NULL;
+        if (task->chunk_mib > 0) {
+            long long chunk_bytes = (long long)task->chunk_mib << 20;
+            task->chunk_count = (int)((jobs[i].size + chunk_bytes - 1) / chunk_bytes);
+        }
+        const InodeResult *done = inode_result_get(jobs[i].dev, jobs[i].ino, task->chunk_mib);
+        if (done) {
+            snprintf(task->actual, sizeof(task->actual), "%s", done->actual);
+            task->digests = done->digests;
+            task->reused = 1;
+        } else if (task->chunk_mib > 0) {
+            task->digests = calloc(task->chunk_count > 0 ? task->chunk_count : 1, CHUNK_DIGEST_SIZE);
+        }
+        jobs[i].inode_task = task_count++;
+    }
+
+    // The queue depth is the thread count; feed it largest files first.
+    // A tree-hashed file is split into its chunks so the whole pool shares it.
+    task_order = malloc((task_count > 0 ? task_count : 1) * sizeof(int));
+    for (int i = 0; i < task_count; i++) task_order[i] = i;
+    qsort(task_order, task_count, sizeof(int), compare_tasks_by_size);
+
+    int unit_capacity = 0;
+    for (int i = 0; i < task_count; i++) {
+        if (!tasks[i].reused) unit_capacity += tasks[i].chunk_mib > 0 ? tasks[i].chunk_count : 1;
+    }
+    units = malloc((unit_capacity > 0 ? unit_capacity : 1) * sizeof(HashUnit));
+    for (int n = 0; n < task_count; n++) {
+        int i = task_order[n];
+        if (tasks[i].reused) continue;
+        inodes_hashed++;
+        if (tasks[i].chunk_mib == 0) {
+            units[unit_count++] = (HashUnit){ i, -1 };
+        } else if (!tasks[i].digests) {
+            tasks[i].failed = 1;
+        } else {
+            for (int c = 0; c < tasks[i].chunk_count; c++) units[unit_count++] = (HashUnit){ i, c };
+        }
+    }
+
+    int thread_count = num_threads < unit_count ? num_threads : unit_count;
+    pthread_t *threads = malloc((thread_count > 0 ? thread_count : 1) * sizeof(pthread_t));
+    int started = 0;
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&threads[started], NULL, hash_worker, NULL) == 0) started++;
+    }
+    if (started == 0) hash_worker(NULL);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].chunk_mib > 0 && !tasks[i].reused && !tasks[i].failed) tree_root(&tasks[i], tasks[i].actual);
+    }
+
+    // One xattr per inode covers every hardlink to it
+    for (int i = 0; trust_xattr && i < task_count; i++) {
+        const VerifyJob *job = &jobs[tasks[i].job];
+        char path[MAX_PATH];
+        if (tasks[i].reused || !tasks[i].actual[0]) continue;
+        if (snprintf(path, sizeof(path), "%s/%s", tree->path, job->rel_path) < (int)sizeof(path)) {
+            store_checksum(path, job, tasks[i].actual);
+        }
+    }
+
+    for (int i = 0; i < job_count; i++) {
+        const char *actual = tasks[jobs[i].inode_task].actual;
+        if (!actual[0]) {
+            fprintf(stderr, "Error: Could not read %s/%s\n", tree->path, jobs[i].rel_path);
+            num_errors++;
+        } else if (strcmp(actual, jobs[i].expected) != 0) {
+            report("CORRUPTED", jobs[i].rel_path);
+            report_chunks(&jobs[i], &tasks[jobs[i].inode_task]);
+            num_corrupted++;
+        } else {
+            if (verbose) report("OK", jobs[i].rel_path);
+            num_ok++;
+        }
+    }
+
+    if (lookup) {
+        find_extras(tree->path, lookup, lookup_prefix);
+        sqlite3_finalize(lookup);
+    }
+    sqlite3_close(manifest_db);
+
+    // Keep what was hashed for the trees still to come
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].reused) continue;
+        const VerifyJob *job = &jobs[tasks[i].job];
+        if (current_tree + 1 < tree_count && tasks[i].actual[0]) {
+            inode_result_put(job->dev, job->ino, tasks[i].chunk_mib, tasks[i].actual, tasks[i].digests);
+        } else {
+            free(tasks[i].digests);
+        }
+    }
+    for (int i = 0; i < job_count; i++) {
+        free(jobs[i].rel_path);
+        free(jobs[i].expected_chunks);
+    }
+    free(jobs);
+    free(tasks);
+    free(units);
+    free(task_order);
+    jobs = NULL;
+    tasks = NULL;
+    units = NULL;
+    task_order = NULL;
+    job_count = job_capacity = task_count = unit_count = next_unit = 0;
+}
+
+int main(int argc, char *argv[]) {
+    char *path_arg = NULL;
+    char *backup_arg = NULL;
+    char *root_arg = NULL;
+    char *db_name = NULL;
+
+    setlocale(LC_NUMERIC, "");
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) path_arg = argv[++i];
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) backup_arg = argv[++i];
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) root_arg = argv[++i];
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) db_name = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) num_threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-v") == 0) verbose = 1;
+        else if (strcmp(argv[i], "-x") == 0) trust_xattr = 1;
+        else if (strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!path_arg || !backup_arg == !root_arg) {
+        fprintf(stderr, "Error: -p and one of -b or -r are required\n\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (num_threads < 1) num_threads = 1;
+
+    snprintf(source_root, sizeof(source_root), "%s", path_arg);
+    strip_trailing_slashes(source_root);
+    if (snprintf(root_lo, sizeof(root_lo), "%s/", source_root) >= (int)sizeof(root_lo) ||
+        snprintf(root_hi, sizeof(root_hi), "%s0", source_root) >= (int)sizeof(root_hi)) {
+        fprintf(stderr, "Error: Source path too long: %s\n", source_root);
+        return 1;
+    }
+
+    if (backup_arg) {
+        trees = calloc(1, sizeof(BackupTree));
+        snprintf(trees[0].path, sizeof(trees[0].path), "%s", backup_arg);
+        strip_trailing_slashes(trees[0].path);
+        trees[0].kind = TREE_MIRROR;
+        tree_count = 1;
+    } else {
+        char root[MAX_PATH];
+        snprintf(root, sizeof(root), "%s", root_arg);
+        strip_trailing_slashes(root);
+        if (find_trees(root) != 0) {
+            fprintf(stderr, "Error: Cannot open backup root %s: %s\n", root, strerror(errno));
+            return 1;
+        }
+        if (tree_count == 0) {
+            fprintf(stderr, "Error: No Base, *_Incremental or *_Snapshot directories in %s\n", root);
+            return 1;
+        }
+    }
+
+    const char *home = getenv("HOME");
+    if (!home) {
+        fprintf(stderr, "Error: HOME environment variable not set\n");
+        return 1;
+    }
+    load_ignore_list();
+
+    char db_path[MAX_PATH];
+    if (db_name) {
+        snprintf(db_path, sizeof(db_path), "%s/db/FileTracker/%s.db", home, db_name);
+    } else {
+        char *path_copy = strdup(source_root);
+        snprintf(db_path, sizeof(db_path), "%s/db/FileTracker/%s.db", home, basename(path_copy));
+        free(path_copy);
+    }
+
+    sqlite3 *db;
+    if (sqlite3_open_v2(db_path, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Error: Failed to open database %s: %s\n", db_path, sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    sqlite3_busy_timeout(db, 30000);
+    int attached = attach_shards(db, db_path);
+    if (attached != 0) {
+        if (attached == -1) fprintf(stderr, "Error: Failed to attach shards of %s: %s\n", db_path, sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+
+    for (current_tree = 0; current_tree < tree_count; current_tree++) {
+        if (verbose && root_arg) printf("Checking %s\n", trees[current_tree].path);
+        verify_tree(db);
+    }
+    sqlite3_close(db);
+
+    printf("\n================ VERIFY SUMMARY ================\n");
+    if (root_arg) printf("Trees          : %'d\n", tree_count);
+    printf("OK             : %'d\n", num_ok);
+    printf("Missing        : %'d\n", num_missing);
+    printf("Corrupted      : %'d\n", num_corrupted);
+    printf("Extra          : %'d\n", num_extra);
+    printf("Unchecked      : %'d\n", num_unchecked);
+    if (root_arg) printf("Outdated       : %'d\n", num_outdated);
+    printf("Errors         : %'d\n", num_errors);
+    printf("Inodes Hashed  : %'d (%'lld bytes)\n", inodes_hashed, bytes_hashed);
+    if (trust_xattr) printf("Cached (xattr) : %'d (not read)\n", num_cached);
+    printf("================================================\n");
+
+    for (int b = 0; b < INODE_BUCKETS; b++) {
+        while (inode_results[b]) {
+            InodeResult *next = inode_results[b]->next;
+            free(inode_results[b]->digests);
+            free(inode_results[b]);
+            inode_results[b] = next;
+        }
+    }
+    free(trees);
+    for (int i = 0; i < ignore_count; i++) free(ignore_list[i]);
+
+    return (num_missing || num_corrupted || num_extra || num_errors) ? 1 : 0;
+}